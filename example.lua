@@ -125,4 +125,197 @@ function example_lua_array()
     return { "hi there", "derp", 1337, -5.5 }
 end
 
-return "top level script can returns values!", 1337
\ No newline at end of file
+function example_struct(record)
+    print("example_struct received: " .. record.id .. ", " .. record.score .. ", " .. record.name)
+
+    return { id = record.id * 2, score = record.score * 2, name = record.name .. record.name }
+end
+
+function example_multiple_returns()
+    local quotient, remainder = example_divide(17, 5)
+    print("example_divide(17, 5) = " .. quotient .. ", " .. remainder)
+end
+
+function example_variant()
+    print("example_describe(nil) = " .. example_describe(nil))
+    print("example_describe(42) = " .. example_describe(42))
+    print("example_describe('herp') = " .. example_describe('herp'))
+    print("example_describe({ 1, 2, 3 }) = " .. example_describe({ 1, 2, 3 }))
+    print("example_describe(ConstructBoxedValue()) = " .. example_describe(ConstructBoxedValue()))
+    print("example_describe(CreateExampleClass(3)) = " .. example_describe(CreateExampleClass(3)))
+
+    -- values no alternative accepts raise an error instead of being guessed at
+    local ok = pcall(example_describe, true)
+    print("example_describe(true) succeeded: " .. tostring(ok))
+end
+
+function example_fixed_size_arrays()
+    print("example_length({ 2, 3, 6 }) = " .. example_length({ 2, 3, 6 }))
+    print("example_sum({ 1, 2, 3, 4, 5 }) = " .. example_sum({ 1, 2, 3, 4, 5 }))
+
+    return { 8, 6, 7, 5, 3, 0, 9 }
+end
+
+function example_table_view()
+    local config = { rate = 2.5, burst = 4 }
+    for i = 1, 500 do
+        config["unused_" .. i] = i
+    end
+
+    print("example_table_view_binding(config) = " .. example_table_view_binding(config))
+end
+
+function example_container_proxy(samples, groups)
+    print("samples has " .. #samples .. " elements, first is " .. samples[1])
+    samples[2] = 20
+    samples[#samples + 1] = 4.5
+
+    for i, sample in ipairs(samples) do
+        print("samples[" .. i .. "] = " .. sample)
+    end
+
+    local primes = groups.primes
+    primes[#primes + 1] = 7
+    groups.evens = { 2, 4, 6 }
+
+    for name, group in pairs(groups) do
+        print("group " .. name .. " has " .. #group .. " elements")
+    end
+end
+
+function example_ffi_buffer(samples, points)
+    -- FFI buffers are 0-based, the loop compiles to native loads and stores
+    local sum = 0
+    for i = 0, #samples - 1 do
+        sum = sum + samples[i]
+        samples[i] = samples[i] * 2
+    end
+    print("sum of " .. #samples .. " samples = " .. sum)
+
+    for i = 0, #points - 1 do
+        local point = points[i]
+        point.x = point.x * point.weight
+        print("point " .. i .. " = (" .. point.x .. ", " .. point.y .. ")")
+    end
+end
+
+function example_jit_diagnostics()
+    -- the pure Lua loop compiles, the loop calling a C++ binding aborts
+    local total = 0
+    for i = 1, 1000 do
+        total = total + i * 2
+    end
+
+    local remainders = 0
+    for i = 1, 1000 do
+        local _, remainder = example_divide(i, 7)
+        remainders = remainders + remainder
+    end
+
+    print("example_jit_diagnostics computed " .. total .. " and " .. remainders)
+end
+
+function example_script_errors(kind)
+    error("example_script_errors raised a " .. kind .. " error")
+end
+
+function example_int64(id)
+    print("example_int64 received " .. tostring(id))
+    return id + 1
+end
+
+function example_properties(particle, steps)
+    for i = 1, steps do
+        particle.x = particle.x + particle.vx
+        particle.y = particle.y + particle.vy
+    end
+    print(particle.kind .. " particle moving at speed " .. particle.speed .. " is at (" .. particle.x .. ", " .. particle.y .. ")")
+
+    local ok, message = pcall(function() particle.speed = 0 end)
+    print("assigning the read only speed property failed: " .. tostring(message))
+
+    local boxed_value = ConstructBoxedValue()
+    boxed_value.value = 42
+    print("boxed_value.value = " .. boxed_value.value .. ", boxed_value:GetValue() = " .. boxed_value:GetValue())
+end
+
+function example_inheritance()
+    local derived = ConstructExampleDerivedValue()
+    derived:SetValue(20)
+    example_add_to_boxed_value(derived, 1)
+    derived:Double()
+
+    print("derived:GetValue() = " .. derived:GetValue() .. ", derived.value = " .. derived.value)
+end
+
+function example_overloads()
+    local boxed_value = ConstructBoxedValue()
+    boxed_value:SetValue(7)
+
+    print("example_overloaded(42) = " .. example_overloaded(42))
+    print("example_overloaded('herp') = " .. example_overloaded('herp'))
+    print("example_overloaded(boxed_value) = " .. example_overloaded(boxed_value))
+    print("example_overloaded(boxed_value, 3) = " .. example_overloaded(boxed_value, 3))
+    -- both classes are userdata, the registered class picks the overload
+    print("example_overloaded(example_class) = " .. example_overloaded(CreateExampleClass(5)))
+    print("example_overloaded(1, 2) = " .. example_overloaded(1, 2))
+end
+
+function example_identity_cache(first, second)
+    print("first == second is " .. tostring(first == second))
+    print("first:ExampleOverload():ExampleOverload() == first is " .. tostring(first:ExampleOverload():ExampleOverload() == first))
+end
+
+function example_borrowed_handles(borrowed)
+    print("borrowed value is " .. borrowed:GetValue())
+    kept_borrow = borrowed
+end
+
+function example_use_kept_borrow()
+    return kept_borrow:GetValue()
+end
+
+function example_print_sink(line_count)
+    -- values that aren't strings are converted like tostring does
+    print("nil: ", nil, ", boolean: ", true, ", number: ", 1.5)
+
+    for i = 1, line_count do
+        print("print sink line ", i)
+    end
+end
+
+function example_tracing()
+    trace_span_begin("example_tracing loop")
+
+    for i = 1, 3 do
+        example_binding("traced", i)
+    end
+
+    trace_span_end()
+end
+
+function example_metrics(call_count)
+    local value = ConstructBoxedValue()
+
+    for i = 1, call_count do
+        value:SetValue(value:GetValue() + i)
+    end
+end
+
+function example_stack_scope()
+    local tenants = {}
+
+    for i = 1, 4 do
+        tenants[i] = { name = "tenant" .. i, rate = i * 2.5 }
+    end
+
+    return { tenants = tenants }
+end
+
+function example_table_path()
+    example_limits = {
+        tenants = { { rate = 10 }, { rate = 20 }, { rate = 30.5 } }
+    }
+end
+
+return "top level script can returns values!", 1337
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <stdexcept>
+
+namespace kdk::glua {
+/**
+ * A read-only view of up to `MaxSize` array elements, backed by inline storage
+ * instead of the heap. Useful as a parameter type for bound functions that
+ * take small variable length arrays (e.g. of numbers) without allocating.
+ *
+ * @tparam T the type of the elements
+ * @tparam MaxSize the maximum number of elements the view can hold
+ */
+template <typename T, size_t MaxSize>
+class ArrayView {
+public:
+    using value_type = T;
+    using const_iterator = const T*;
+
+    ArrayView() = default;
+
+    /**
+   * @brief appends an element to the view, used when filling it
+   *
+   * @throws std::length_error if the view is already full
+   */
+    auto PushBack(T value) -> void
+    {
+        if (m_size == MaxSize) {
+            throw std::length_error("ArrayView is full");
+        }
+
+        m_storage[m_size++] = std::move(value);
+    }
+
+    auto size() const -> size_t { return m_size; }
+    auto empty() const -> bool { return m_size == 0; }
+    auto data() const -> const T* { return m_storage.data(); }
+
+    auto begin() const -> const_iterator { return m_storage.data(); }
+    auto end() const -> const_iterator { return m_storage.data() + m_size; }
+
+    auto operator[](size_t index) const -> const T& { return m_storage[index]; }
+
+    /**
+   * @throws std::out_of_range if index is not less than size()
+   */
+    auto at(size_t index) const -> const T&
+    {
+        if (index >= m_size) {
+            throw std::out_of_range("ArrayView::at index out of range");
+        }
+
+        return m_storage[index];
+    }
+
+private:
+    std::array<T, MaxSize> m_storage {};
+    size_t m_size = 0;
+};
+} // namespace kdk::glua
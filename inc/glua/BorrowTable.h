@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace kdk::glua {
+/**
+ * The generation counted slots of a BorrowTable. Borrows share them, so a
+ * borrow outliving its table is stale instead of dangling
+ */
+class BorrowSlots {
+public:
+    /**
+   * @brief takes a free slot
+   *
+   * @return the slot and its current generation
+   */
+    auto Acquire() -> std::pair<uint32_t, uint32_t>;
+    auto Release(uint32_t slot, uint32_t generation) -> void;
+    auto ReleaseAll() -> void;
+
+    auto IsValid(uint32_t slot, uint32_t generation, uint64_t epoch) const -> bool
+    {
+        return epoch == m_epoch && m_generations[slot] == generation;
+    }
+    auto GetEpoch() const -> uint64_t { return m_epoch; }
+
+private:
+    std::vector<uint32_t> m_generations;
+    std::vector<uint32_t> m_free_slots;
+    size_t m_used_count = 0; // slots past this were never taken this epoch
+    uint64_t m_epoch = 0;
+};
+
+/**
+ * An object lent to the scripting environment from a BorrowTable. Pushing it
+ * gives a userdata of the object's registered class, which raises a script
+ * error when used after the borrow was released
+ */
+template <typename T>
+class Borrowed {
+public:
+    Borrowed(T& value, std::shared_ptr<BorrowSlots> slots)
+        : m_value(&value)
+        , m_slots(std::move(slots))
+        , m_epoch(m_slots->GetEpoch())
+    {
+        std::tie(m_slot, m_generation) = m_slots->Acquire();
+    }
+
+    auto Get() const -> T& { return *m_value; }
+
+    auto IsValid() const -> bool
+    {
+        return m_slots->IsValid(m_slot, m_generation, m_epoch);
+    }
+
+    auto Release() const -> void
+    {
+        if (IsValid()) {
+            m_slots->Release(m_slot, m_generation);
+        }
+    }
+
+private:
+    T* m_value;
+    std::shared_ptr<BorrowSlots> m_slots;
+    uint64_t m_epoch;
+    uint32_t m_slot = 0;
+    uint32_t m_generation = 0;
+};
+
+/**
+ * Lends objects to the scripting environment by reference without trusting
+ * it to drop them in time. Borrows are released one by one or all at once,
+ * e.g. at the end of a request, which costs O(1) however many are out
+ */
+class BorrowTable {
+public:
+    BorrowTable();
+    BorrowTable(const BorrowTable&) = delete;
+    BorrowTable(BorrowTable&&) noexcept = default;
+
+    auto operator=(const BorrowTable&) -> BorrowTable& = delete;
+    auto operator=(BorrowTable&&) noexcept -> BorrowTable& = default;
+
+    /**
+   * @brief lends `value` until the borrow is released, the caller guarantees
+   * it outlives the borrow
+   */
+    template <typename T>
+    auto Borrow(T& value) -> Borrowed<T>
+    {
+        return Borrowed<T> { value, m_slots };
+    }
+
+    template <typename T>
+    auto Release(const Borrowed<T>& borrowed) -> void
+    {
+        borrowed.Release();
+    }
+
+    auto ReleaseAll() -> void;
+
+    ~BorrowTable();
+
+private:
+    std::shared_ptr<BorrowSlots> m_slots;
+};
+
+} // namespace kdk::glua
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace kdk::glua {
+class GluaBase;
+
+/**
+ * Interface for a C++ container exposed to the scripting environment by
+ * reference. The scripting environment reads and writes the container
+ * through these methods, so nothing is copied up front.
+ *
+ * Stack indices refer to the arguments of the scripting environment's
+ * index/newindex/next operations.
+ */
+class IContainerProxy {
+public:
+    IContainerProxy() = default;
+    IContainerProxy(const IContainerProxy&) = default;
+    IContainerProxy(IContainerProxy&&) noexcept = default;
+
+    auto operator=(const IContainerProxy&) -> IContainerProxy& = default;
+    auto operator=(IContainerProxy&&) noexcept -> IContainerProxy& = default;
+
+    /**
+   * @brief pushes the value for the key at `key_index`, or null if there is
+   * none
+   */
+    virtual auto Index(GluaBase* glua, int key_index) -> void = 0;
+    /**
+   * @brief sets the value for the key at `key_index` to the value at
+   * `value_index`
+   */
+    virtual auto NewIndex(GluaBase* glua, int key_index, int value_index)
+        -> void
+        = 0;
+    /**
+   * @return the number of elements in the container
+   */
+    virtual auto Length() const -> size_t = 0;
+    /**
+   * @brief pushes the key and value following the key at `key_index` (the
+   * first key and value if it is null)
+   *
+   * Like with tables, keys may be removed while iterating, including the
+   * current one, but keys added while iterating may or may not be visited.
+   * Only the most recent iteration over the proxy can continue after its
+   * current key was removed, an outer loop over the same proxy throws
+   * instead.
+   *
+   * @return false if there are no more elements, in which case nothing is
+   * pushed
+   */
+    virtual auto Next(GluaBase* glua, int key_index) -> bool = 0;
+
+    /**
+   * @return the type of the container, e.g. std::vector<double>
+   */
+    virtual auto GetContainerType() const -> std::type_index = 0;
+    /**
+   * @return the address of the container
+   */
+    virtual auto GetContainer() const -> void* = 0;
+
+    virtual ~IContainerProxy() = default;
+};
+
+/**
+ * Exposes a std::vector or std::unordered_map<std::string, T> by reference.
+ * Elements that are containers themselves are exposed by reference as well,
+ * all other elements are converted by value when accessed.
+ *
+ * @tparam Container the container type
+ * @tparam Holder how the container is held, either a raw pointer (the caller
+ * guarantees the lifetime) or a std::shared_ptr (the proxy shares ownership)
+ */
+template <typename Container, typename Holder>
+class ContainerProxy : public IContainerProxy {
+public:
+    explicit ContainerProxy(Holder holder)
+        : m_holder(std::move(holder))
+    {
+    }
+
+    auto Index(GluaBase* glua, int key_index) -> void override;
+    auto NewIndex(GluaBase* glua, int key_index, int value_index)
+        -> void override;
+    auto Length() const -> size_t override { return m_holder->size(); }
+    auto Next(GluaBase* glua, int key_index) -> bool override;
+
+    auto GetContainerType() const -> std::type_index override
+    {
+        return std::type_index { typeid(Container) };
+    }
+    auto GetContainer() const -> void* override { return &*m_holder; }
+
+    auto GetHolder() const -> const Holder& { return m_holder; }
+
+    ~ContainerProxy() override = default;
+
+private:
+    /**
+   * Where iterating a map left off. The key following the last returned one
+   * is remembered so iteration can continue after the last returned key was
+   * erased
+   */
+    struct MapCursor {
+        std::string key;
+        std::optional<std::string> next_key; // not set at the last element
+    };
+
+    Holder m_holder;
+    std::optional<MapCursor> m_cursor;
+};
+
+template <typename T>
+struct IsProxiedContainer : std::false_type {
+};
+
+template <typename T>
+struct IsProxiedContainer<std::vector<T>> : std::true_type {
+};
+
+template <typename T>
+struct IsProxiedContainer<std::unordered_map<std::string, T>> : std::true_type {
+};
+} // namespace kdk::glua
+
+// .tcc implementation file is included by GluaBase.h instead to avoid circular
+// dependency
@@ -0,0 +1,153 @@
+#include "glua/ContainerProxy.h"
+
+namespace kdk::glua {
+template <typename Element>
+auto push_proxied_element(GluaBase* glua, Element& element) -> void
+{
+    if constexpr (IsProxiedContainer<Element>::value) {
+        // nested containers are exposed by reference too
+        glua->Push(std::ref(element));
+    } else {
+        glua->Push(element);
+    }
+}
+
+template <typename Container, typename Holder>
+auto ContainerProxy<Container, Holder>::Index(GluaBase* glua, int key_index)
+    -> void
+{
+    auto& container = *m_holder;
+
+    if constexpr (std::is_same<Container, std::vector<typename Container::value_type>>::value) {
+        if (glua->Is<size_t>(key_index)) {
+            auto index = glua->As<size_t>(key_index) - glua->transformObjectIndex(0);
+
+            if (index < container.size()) {
+                push_proxied_element(glua, container[index]);
+                return;
+            }
+        }
+    } else {
+        if (glua->Is<std::string>(key_index)) {
+            auto pos = container.find(glua->As<std::string>(key_index));
+
+            if (pos != container.end()) {
+                push_proxied_element(glua, pos->second);
+                return;
+            }
+        }
+    }
+
+    glua->push(std::nullopt);
+}
+
+template <typename Container, typename Holder>
+auto ContainerProxy<Container, Holder>::NewIndex(GluaBase* glua, int key_index,
+    int value_index) -> void
+{
+    auto& container = *m_holder;
+
+    if constexpr (std::is_same<Container, std::vector<typename Container::value_type>>::value) {
+        using Element = typename Container::value_type;
+
+        auto index = glua->Get<size_t>(key_index) - glua->transformObjectIndex(0);
+
+        if (index < container.size()) {
+            glua->GetInto(value_index, container[index]);
+        } else if (index == container.size()) {
+            // like a table, assigning one past the end appends
+            container.push_back(glua->Get<Element>(value_index));
+        } else {
+            throw exceptions::GluaBaseException(
+                "Assigned out of range index " + std::to_string(index) + " of vector of size "
+                + std::to_string(container.size()));
+        }
+    } else {
+        using Element = typename Container::mapped_type;
+
+        auto key = glua->Get<std::string>(key_index);
+
+        if (glua->isNull(value_index)) {
+            // like a table, assigning nil removes the key
+            container.erase(key);
+        } else {
+            auto pos = container.find(key);
+
+            if (pos != container.end()) {
+                glua->GetInto(value_index, pos->second);
+            } else {
+                container.emplace(std::move(key), glua->Get<Element>(value_index));
+            }
+        }
+    }
+}
+
+template <typename Container, typename Holder>
+auto ContainerProxy<Container, Holder>::Next(GluaBase* glua, int key_index)
+    -> bool
+{
+    auto& container = *m_holder;
+
+    if constexpr (std::is_same<Container, std::vector<typename Container::value_type>>::value) {
+        size_t index = 0;
+
+        if (!glua->isNull(key_index)) {
+            index = glua->As<size_t>(key_index) - glua->transformObjectIndex(0) + 1;
+        }
+
+        if (index < container.size()) {
+            glua->Push(glua->transformObjectIndex(index));
+            push_proxied_element(glua, container[index]);
+            return true;
+        }
+    } else {
+        auto pos = container.begin();
+
+        if (!glua->isNull(key_index)) {
+            auto key = glua->As<std::string>(key_index);
+
+            pos = container.find(key);
+
+            if (pos != container.end()) {
+                ++pos;
+            } else if (m_cursor.has_value() && m_cursor->key == key) {
+                // the current key was erased, e.g. by assigning nil to it, so
+                // continue from the key that followed it
+                if (m_cursor->next_key.has_value()) {
+                    pos = container.find(*m_cursor->next_key);
+
+                    if (pos == container.end()) {
+                        throw exceptions::GluaBaseException("Invalid key to next, both \""
+                            + key + "\" and the key following it were removed while iterating");
+                    }
+                }
+            } else {
+                throw exceptions::GluaBaseException(
+                    "Invalid key to next, \"" + key + "\" is not in the map");
+            }
+        }
+
+        if (pos != container.end()) {
+            if (!m_cursor.has_value()) {
+                m_cursor.emplace();
+            }
+
+            m_cursor->key = pos->first;
+
+            if (auto next = std::next(pos); next != container.end()) {
+                m_cursor->next_key = next->first;
+            } else {
+                m_cursor->next_key.reset();
+            }
+
+            glua->Push(pos->first);
+            push_proxied_element(glua, pos->second);
+            return true;
+        }
+
+        m_cursor.reset();
+    }
+
+    return false;
+}
+} // namespace kdk::glua
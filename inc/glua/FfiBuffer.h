@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace kdk::glua {
+/**
+ * A contiguous buffer of numbers or GLUA_STRUCT PODs handed to LuaJIT as FFI
+ * cdata instead of being converted element by element. Scripts index the
+ * buffer directly (`buffer[0]`, `buffer.data[i]`, `#buffer`), which the JIT
+ * compiles to native loads and stores.
+ *
+ * Indices are 0-based like any FFI pointer and are not bounds checked. The
+ * buffer must not be reallocated (e.g. by resizing its vector) while Lua may
+ * still use it.
+ *
+ * @tparam T arithmetic type or standard layout GLUA_STRUCT whose fields are
+ * all listed in declaration order
+ */
+template <typename T>
+class FfiBuffer {
+public:
+    static_assert(!std::is_const<T>::value, "FFI buffers are writable from Lua");
+
+    /**
+   * @brief the caller guarantees the data outlives every use from Lua
+   */
+    FfiBuffer(T* data, size_t size)
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    /**
+   * @brief Lua keeps `owner` alive for as long as it holds the buffer
+   */
+    FfiBuffer(T* data, size_t size, std::shared_ptr<const void> owner)
+        : m_data(data)
+        , m_size(size)
+        , m_owner(std::move(owner))
+    {
+    }
+
+    /**
+   * @brief shares ownership of the vector, which must not be resized while
+   * Lua holds the buffer
+   */
+    explicit FfiBuffer(std::shared_ptr<std::vector<T>> vector)
+        : m_data(vector->data())
+        , m_size(vector->size())
+        , m_owner(std::move(vector))
+    {
+    }
+
+    auto Data() const -> T* { return m_data; }
+    auto Size() const -> size_t { return m_size; }
+    auto GetOwner() const -> const std::shared_ptr<const void>& { return m_owner; }
+
+    auto begin() const -> T* { return m_data; }
+    auto end() const -> T* { return m_data + m_size; }
+
+    auto operator[](size_t index) const -> T& { return m_data[index]; }
+
+private:
+    T* m_data;
+    size_t m_size;
+    std::shared_ptr<const void> m_owner;
+};
+} // namespace kdk::glua
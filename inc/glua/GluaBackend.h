@@ -0,0 +1,19 @@
+#pragma once
+
+/**
+ * GluaBackend is the backend selected at build time, GluaLua for LuaJIT or
+ * GluaLua54 for Lua 5.4 when GLUA_BACKEND_LUA54 is defined
+ */
+#if defined(GLUA_BACKEND_LUA54)
+#include "glua/GluaLua54.h"
+
+namespace kdk::glua {
+using GluaBackend = GluaLua54;
+} // namespace kdk::glua
+#else
+#include "glua/GluaLua.h"
+
+namespace kdk::glua {
+using GluaBackend = GluaLua;
+} // namespace kdk::glua
+#endif
@@ -1,14 +1,22 @@
 #pragma once
 
+#include "glua/ContainerProxy.h"
 #include "glua/Exceptions.h"
 #include "glua/GluaCallable.h"
 #include "glua/GluaManagedTypeStorage.h"
+#include "glua/GluaOverloadedCallable.h"
 #include "glua/ICallable.h"
+#include "glua/LuaTableView.h"
 #include "glua/StackPosition.h"
+#include "glua/StackScope.h"
 #include "glua/StringUtil.h"
+#include "glua/TablePath.h"
 
+#include <algorithm>
+#include <functional>
 #include <optional>
 #include <string>
+#include <tuple>
 #include <type_traits>
 #include <typeindex>
 #include <unordered_map>
@@ -17,10 +25,42 @@
 #define REGISTER_TO_GLUA(glua, functor) \
     glua.RegisterCallable(#functor, (glua).CreateGluaCallable(functor))
 
+#define REGISTER_FFI_TO_GLUA(glua, function) \
+    glua.RegisterFfiFunction(#function, function)
+
 #define REGISTER_CLASS_TO_GLUA(glua, ClassType, ...) \
     glua.RegisterClassMultiString<ClassType>(#__VA_ARGS__, __VA_ARGS__)
 
+// must be used at global namespace scope, e.g.:
+// GLUA_STRUCT(Point, &Point::x, &Point::y)
+#define GLUA_STRUCT(StructType, ...)                                   \
+    namespace kdk::glua {                                              \
+    template <>                                                        \
+    struct GluaStructFields<StructType> {                              \
+        static constexpr auto members = std::make_tuple(__VA_ARGS__);  \
+        static auto names() -> const std::vector<std::string>&         \
+        {                                                              \
+            static const auto field_names                              \
+                = parse_struct_field_names(#__VA_ARGS__);              \
+            return field_names;                                        \
+        }                                                              \
+    };                                                                 \
+    }
+
 namespace kdk::glua {
+/**
+ * The basic type of a value on the glua stack, as reported by the scripting
+ * language
+ */
+enum class GluaValueType { NIL,
+    BOOLEAN,
+    NUMBER,
+    STRING,
+    TABLE,
+    USERDATA,
+    FUNCTION,
+    OTHER };
+
 /**
  * Base for a Glua instance that can serve as an argument stack for a
  * DeferredArgumentCaller, while providing the shared logic for type deduction
@@ -240,7 +280,9 @@ public:
     /**
    * @brief Gets the value of the item at the given position in the stack and
    * checks to make sure it is of type `Type`. If so it is returned, otherwise
-   * an error is thrown
+   * an error is thrown. Numbers and strings are checked and converted in a
+   * single step, and integer types reject numbers with a fractional part or
+   * outside of their range
    *
    *
    * @tparam Type the type of the value that it should be retrieved as
@@ -254,6 +296,34 @@ public:
     template <typename Type>
     auto Get(int stack_index) -> Type;
 
+    /**
+   * @brief Converts the value of the item at the given position in the stack
+   * into an existing object. Containers are cleared and refilled, reusing
+   * their capacity and, where possible, the capacity of their elements, which
+   * avoids reallocating when the same kind of value is read repeatedly
+   *
+   * @tparam Type the type of the value that it should be converted to
+   * @param stack_index the index of the element to retrieve (negative indices work
+   *                    from the top of the stack, e.g. -1  is the top of the stack, 0 is the
+   *                    bottom, and 1 is 1 from the bottom)
+   * @param out the object to convert the value into
+   */
+    template <typename Type>
+    auto AsInto(int stack_index, Type& out) -> void;
+
+    /**
+   * @brief Like AsInto, but first checks to make sure the value is of type
+   * `Type`, otherwise an error is thrown and `out` is left unchanged
+   *
+   * @tparam Type the type of the value that it should be retrieved as
+   * @param stack_index the index of the element to retrieve
+   * @param out the object to convert the value into
+   * @throws std::runtime_error if the value at the given index is not of type
+   * `Type`
+   */
+    template <typename Type>
+    auto GetInto(int stack_index, Type& out) -> void;
+
     /**
    * @brief Gets the value at the top of the stack and pops it off the stack
    *
@@ -284,6 +354,22 @@ public:
    */
     auto GetArrayLength(int stack_index) -> size_t;
 
+    /**
+   * @brief Converts the elements of the array at the given index into
+   * caller-provided storage, without allocating
+   *
+   * @tparam T the type to convert each element to
+   * @param stack_index the index of the array
+   * @param buffer the storage to write the converted elements to
+   * @param capacity the number of elements `buffer` can hold
+   * @return the number of elements written to `buffer`
+   *
+   * @throws exceptions::GluaTypeException if the array has more than
+   * `capacity` elements
+   */
+    template <typename T>
+    auto ReadArray(int stack_index, T* buffer, size_t capacity) -> size_t;
+
     /**
    * @brief Sets a global value with the given name to the given value
    *
@@ -307,6 +393,17 @@ public:
 
     /**
    * @brief Retrieves the value of the requested global from the scripting
+   * environment into an existing object, reusing its capacity, see AsInto
+   *
+   * @tparam T the type to receive the global value as
+   * @param name the name of the global in the scripting environment to retrieve
+   * @param out the object to receive the global value
+   */
+    template <typename T>
+    auto GetGlobalInto(const std::string& name, T& out) -> void;
+
+    /**
+   * @brief Retrieves the value of the requested global from the scripting
    * environment and pushes it on the variable stack. The stack position of the
    * global is returned.
    *
@@ -327,6 +424,41 @@ public:
    */
     template <typename Functor>
     auto CreateGluaCallable(Functor&& f) -> Callable;
+    /**
+   * @brief Creates one callable from several functors, e.g. the overloads of a
+   * function, which can be registered under one name. Each call goes to the
+   * first functor whose argument count and value types match the arguments,
+   * looked up in a table generated from the signatures at compile time, then
+   * to the first functor the arguments can be converted for. Trailing
+   * std::optional parameters may be left out
+   *
+   * @tparam Functors the types of the functors
+   * @param functors the functors, in the order they're tried
+   * @return Callable a callable dispatching to the functors
+   */
+    template <typename... Functors>
+    auto CreateGluaOverloads(Functors&&... functors) -> Callable;
+    /**
+   * @brief Registers a plain function as an FFI function pointer instead of a
+   * callable, so LuaJIT can compile calls to it into traces rather than
+   * leaving compiled code on every call. Parameters and the return value must
+   * be numbers, bool, GLUA_STRUCTs of those, or pointers to any of these. The
+   * function must not throw. Backends without an FFI throw
+   *
+   * @param name the name the function should be called with from the scripting
+   * environment
+   * @param function the function to register
+   */
+    template <typename ReturnType, typename... Params>
+    auto RegisterFfiFunction(const std::string& name,
+        ReturnType (*function)(Params...)) -> void;
+
+    /**
+   * @brief Registers `trace_span_begin(name)` and `trace_span_end()`, so
+   * scripts can add their own spans to the script_tracer timeline. Both do
+   * nothing while tracing is off
+   */
+    auto RegisterTraceFunctions() -> void;
 
     /**
    * @brief Registers a class from a multi string. This string is generally
@@ -373,6 +505,63 @@ public:
     template <typename ClassType>
     auto RegisterMethod(const std::string& method_name, Callable method) -> void;
 
+    /**
+   * @brief Declares that an already registered class derives from an already
+   * registered base class. Instances of the derived class fall back to the
+   * base's methods and properties, and are accepted by bindings taking the
+   * base by value, reference, pointer or shared_ptr
+   *
+   * @tparam ClassType the already registered derived class type
+   * @tparam BaseType the already registered base class type
+   */
+    template <typename ClassType, typename BaseType>
+    auto RegisterBaseClass() -> void;
+
+    /**
+   * @brief Enables or disables the identity cache of an already registered
+   * class. While enabled, pushing an object already pushed by pointer,
+   * reference or shared_ptr pushes the same userdata again, as long as the
+   * script still references it, instead of allocating a new one. Handles to
+   * the same object then compare equal with ==. An object pushed by raw
+   * pointer or reference isn't reused for a push by shared_ptr, which must
+   * share ownership
+   *
+   * @tparam ClassType the already registered class type
+   * @param enabled whether the class's instances are cached
+   */
+    template <typename ClassType>
+    auto SetIdentityCacheEnabled(bool enabled) -> void;
+
+    /**
+   * @brief Registers a property to an already registered class, read and
+   * written from Lua as a field, e.g. `object.name = object.name + 1`
+   *
+   * A pointer to a data member gives a read/write property (read only when
+   * the member is const), a pointer to a member function taking no arguments
+   * gives a read only property returning its result.
+   *
+   * @tparam ClassType the already registered class type
+   * @param property_name the name of the property
+   * @param accessor the data member or getter, e.g. &ClassName::value
+   */
+    template <typename ClassType, typename Accessor>
+    auto RegisterProperty(const std::string& property_name, Accessor accessor)
+        -> void;
+
+    /**
+   * @brief Registers a read/write property to an already registered class,
+   * backed by a getter and setter pair
+   *
+   * @tparam ClassType the already registered class type
+   * @param property_name the name of the property
+   * @param getter the member function or callable taking the object
+   * @param setter the member function or callable taking the object and the
+   * assigned value
+   */
+    template <typename ClassType, typename Getter, typename Setter>
+    auto RegisterProperty(const std::string& property_name, Getter getter,
+        Setter setter) -> void;
+
     /**
    * @brief Runs a file, by reading the data in from the file and calling
    * RunScript
@@ -409,6 +598,25 @@ public:
     auto CallScriptFunction(const std::string& function_name, Params&&... params)
         -> std::vector<StackPosition>;
 
+    /**
+   * @brief Calls a function in the scripting environment with the given name
+   * using the given parameters, and converts its return values to
+   * `ReturnType`. All return values are popped off the stack before returning.
+   * Multiple return values can be received as a std::tuple or std::pair
+   *
+   * @tparam ReturnType the type to receive the return value(s) as, may be void
+   * @tparam Params the types of the parameters passed
+   * @param function_name the name of the function in the scripting environment
+   * to call
+   * @param params the parameter values to call the function with
+   *
+   * @return the return value(s) of the function
+   * @throws std::runtime_error if the return values are not of `ReturnType`
+   */
+    template <typename ReturnType, typename... Params>
+    auto CallScriptFunctionAs(const std::string& function_name,
+        Params&&... params) -> ReturnType;
+
     /**
    * @brief defaulted virtual destructor
    */
@@ -440,6 +648,32 @@ protected:
         std::unique_ptr<IManagedTypeStorage> user_storage)
         -> void
         = 0;
+    /**
+   * @brief pushes the userdata cached for the object at `address` if its class
+   * has the identity cache enabled, see SetIdentityCacheEnabled
+   *
+   * @return true if a cached userdata was pushed
+   */
+    virtual auto pushCachedUserType(const std::string& unique_type_name,
+        const void* address, bool requires_ownership) -> bool
+        = 0;
+    virtual auto pushContainerProxy(std::unique_ptr<IContainerProxy> proxy)
+        -> void
+        = 0;
+    /**
+   * @brief declares the FFI type `type_name` from `cdef` and checks that its
+   * size matches the C++ type
+   */
+    virtual auto defineFfiType(const std::string& type_name,
+        const std::string& cdef, size_t expected_size) -> void
+        = 0;
+    virtual auto pushFfiBuffer(const std::string& element_type_name,
+        void* data, size_t size, std::shared_ptr<const void> owner)
+        -> void
+        = 0;
+    virtual auto registerFfiFunctionImpl(const std::string& name,
+        const std::string& signature, void* function) -> void
+        = 0;
     virtual auto getBool(int stack_index) const -> bool = 0;
     virtual auto getInt8(int stack_index) const -> int8_t = 0;
     virtual auto getInt16(int stack_index) const -> int16_t = 0;
@@ -452,6 +686,25 @@ protected:
     virtual auto getFloat(int stack_index) const -> float = 0;
     virtual auto getDouble(int stack_index) const -> double = 0;
     virtual auto getCharPointer(int stack_index) const -> const char* = 0;
+    /**
+   * @return the number at `stack_index` (converting numeric strings), or
+   * nullopt if it isn't one, checking and converting in a single call
+   */
+    virtual auto tryGetNumber(int stack_index) const -> std::optional<double> = 0;
+    /**
+   * @return the value at `stack_index` if the backend holds it as an integer,
+   * or nullopt for any other value, including integral floating point numbers
+   */
+    virtual auto tryGetInteger(int stack_index) const
+        -> std::optional<int64_t>
+        = 0;
+    /**
+   * @return the string at `stack_index` (converting numbers), or nullopt if
+   * it isn't one, checking and converting in a single call
+   */
+    virtual auto tryGetStringView(int stack_index) const
+        -> std::optional<std::string_view>
+        = 0;
     virtual auto getStringView(int stack_index) const -> std::string_view = 0;
     virtual auto getString(int stack_index) const -> std::string = 0;
     virtual auto getArraySize(int stack_index) const -> size_t = 0;
@@ -460,14 +713,43 @@ protected:
         = 0;
     virtual auto getMapKeys(int stack_index) const
         -> std::vector<std::string> = 0;
-    virtual auto getMapValue(const std::string& key, int stack_index_of_map) const
+    virtual auto getMapValue(std::string_view key, int stack_index_of_map) const
+        -> void
+        = 0;
+    virtual auto nextMapEntry(int stack_index_of_map) const -> bool = 0;
+    virtual auto pushValueCopy(int stack_index) -> void = 0;
+    virtual auto internKey(std::string_view key) -> int = 0;
+    virtual auto pushInternedKey(int key_ref) -> void = 0;
+    virtual auto getInternedMapValue(int key_ref, int stack_index_of_map) const
         -> void
         = 0;
+    /**
+   * @brief replaces the value on top of the stack with the value at the end of
+   * `segments`, using raw gets and stopping at the first value that isn't a
+   * table, see TablePath
+   */
+    virtual auto walkTablePath(const TablePathSegment* segments,
+        size_t segment_count) -> void
+        = 0;
     virtual auto getUserType(const std::string& unique_type_name,
         int stack_index) const -> IManagedTypeStorage* = 0;
     virtual auto isUserType(const std::string& unique_type_name,
         int stack_index) const -> bool
         = 0;
+    /**
+   * @return the container proxy at `stack_index`, or nullptr if the value is
+   * not one
+   */
+    virtual auto getContainerProxy(int stack_index) const -> IContainerProxy* = 0;
+    virtual auto getValueType(int stack_index) const -> GluaValueType = 0;
+    /**
+   * @return the data and size of the FFI buffer at `stack_index`, or nullopt
+   * if the value is not a buffer of `element_type_name`
+   */
+    virtual auto getFfiBuffer(const std::string& element_type_name,
+        int stack_index) const
+        -> std::optional<std::pair<void*, size_t>>
+        = 0;
     virtual auto isNull(int stack_index) const -> bool = 0;
     virtual auto isBool(int stack_index) const -> bool = 0;
     virtual auto isInt8(int stack_index) const -> bool = 0;
@@ -490,7 +772,16 @@ protected:
         = 0;
     virtual auto pushGlobal(const std::string& name) -> void = 0;
     virtual auto popOffStack(size_t count) -> void = 0;
+    /**
+   * @brief removes the value at stack_index, shifting the values above it down
+   */
+    virtual auto removeFromStack(int stack_index) -> void = 0;
     virtual auto getStackTop() -> int = 0;
+    /**
+   * @brief drops or null-pads the stack to exactly `stack_top` values in a
+   * single operation, see StackScope
+   */
+    virtual auto setStackTop(int stack_top) -> void = 0;
     virtual auto callScriptFunctionImpl(const std::string& function_name,
         size_t arg_count = 0) -> void
         = 0;
@@ -503,17 +794,45 @@ protected:
         const std::string& method_name,
         Callable method) -> void
         = 0;
+    virtual auto registerBaseClassImpl(const std::string& class_name,
+        const std::string& base_class_name) -> void
+        = 0;
+    virtual auto registerAncestorClassImpl(const std::string& class_name,
+        const std::string& ancestor_class_name) -> void
+        = 0;
+    virtual auto setIdentityCacheEnabledImpl(const std::string& class_name,
+        bool enabled) -> void
+        = 0;
+    virtual auto registerPropertyImpl(const std::string& class_name,
+        const std::string& property_name, Callable getter,
+        std::optional<Callable> setter) -> void
+        = 0;
     virtual auto transformObjectIndex(size_t index) -> size_t = 0;
     virtual auto transformFunctionParameterIndex(size_t index) -> size_t = 0;
     virtual auto runScript(std::string_view script_data) -> void = 0;
     /********************************************************************************/
 
 private:
+    auto absoluteStackIndex(int stack_index) -> int;
+
     template <typename T>
     auto getUniqueClassName() const
         -> std::optional<std::reference_wrapper<const std::string>>;
     template <typename T>
     auto setUniqueClassName(std::string metatable_name) -> void;
+    template <typename T>
+    auto getStoredUserType(IManagedTypeStorage* storage) -> T*;
+    auto upcastUserType(IManagedTypeStorage* storage, std::type_index target)
+        -> void*;
+    auto addUpcast(std::type_index derived, std::type_index base,
+        std::function<void*(void*)> upcast) -> void;
+    template <typename T>
+    auto getInternedStructKeys() -> const std::vector<int>&;
+    auto internPathKey(std::string_view key) -> int;
+    template <typename T>
+    auto getFfiTypeName() -> const std::string&;
+    template <typename T>
+    auto getFfiSignatureTypeName() -> std::string;
 
     template <typename Functor>
     auto createGluaCallableImpl(Functor f) -> Callable;
@@ -534,10 +853,27 @@ private:
         -> Callable;
 
     std::unordered_map<std::type_index, std::string> m_class_to_metatable_name;
+    // derived class -> every ancestor class -> pointer upcast to it
+    std::unordered_map<std::type_index,
+        std::unordered_map<std::type_index, std::function<void*(void*)>>>
+        m_class_upcasts;
+    std::unordered_map<std::type_index, std::vector<int>> m_interned_struct_keys;
+    // shared by every TablePath so compiling paths doesn't keep adding refs
+    std::unordered_map<std::string, int> m_interned_path_keys;
+    std::unordered_map<std::type_index, std::string> m_ffi_type_names;
 
     // friends for template resolvers
     template <typename T>
     friend struct GluaResolver;
+    friend class LuaTableView;
+    friend class StackScope;
+    friend class TablePath;
+    template <typename Container, typename Holder>
+    friend class ContainerProxy;
+    template <typename Functor, typename... Params>
+    friend auto glua_callable_thunk(GluaBase* glua, void* functor) -> int;
+    template <size_t OverloadCount, size_t MaxArity>
+    friend class GluaOverloadedCallable;
 };
 
 } // namespace kdk::glua
@@ -545,4 +881,14 @@ private:
 // include stack position implementation to avoid circular dependency
 #include "glua/StackPosition.tcc"
 
+#include "glua/StackScope.tcc"
+
+#include "glua/TablePath.tcc"
+
+#include "glua/LuaTableView.tcc"
+
+#include "glua/ContainerProxy.tcc"
+
 #include "glua/GluaBase.tcc"
+
+#include "glua/GluaOverloadedCallable.tcc"
@@ -105,12 +105,45 @@ auto GluaBase::As(int stack_index) -> Type
 
 template <typename Type>
 auto GluaBase::Get(int stack_index) -> Type
+{
+    if constexpr (HasTryAs<Type>::value) {
+        // checks and converts in one step
+        auto value = GluaResolver<Type>::tryAs(this, stack_index);
+
+        if (value.has_value()) {
+            return std::move(value).value();
+        }
+
+        throw exceptions::GluaTypeException(
+            "GluaBase::Get with invalid type or out of range value");
+    } else {
+        if (Is<Type>(stack_index)) {
+            return As<Type>(stack_index);
+        }
+
+        throw std::runtime_error("GluaBase::Get with invalid type");
+    }
+}
+
+template <typename Type>
+auto GluaBase::AsInto(int stack_index, Type& out) -> void
+{
+    if constexpr (HasAsInto<Type>::value) {
+        GluaResolver<Type>::asInto(this, stack_index, out);
+    } else {
+        out = As<Type>(stack_index);
+    }
+}
+
+template <typename Type>
+auto GluaBase::GetInto(int stack_index, Type& out) -> void
 {
     if (Is<Type>(stack_index)) {
-        return As<Type>(stack_index);
+        AsInto(stack_index, out);
+        return;
     }
 
-    throw std::runtime_error("GluaBase::Get with invalid type");
+    throw std::runtime_error("GluaBase::GetInto with invalid type");
 }
 
 template <typename T>
@@ -126,6 +159,26 @@ auto GluaBase::Pop() -> T
     }
 }
 
+template <typename T>
+auto GluaBase::ReadArray(int stack_index, T* buffer, size_t capacity) -> size_t
+{
+    auto count = getArraySize(stack_index);
+
+    if (count > capacity) {
+        throw exceptions::GluaTypeException(
+            "Array of length " + std::to_string(count) + " exceeds buffer capacity of "
+            + std::to_string(capacity));
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        getArrayValue(transformObjectIndex(i), stack_index);
+        buffer[i] = As<T>(-1);
+        popOffStack(1);
+    }
+
+    return count;
+}
+
 template <typename T>
 auto GluaBase::GetGlobal(const std::string& name) -> T
 {
@@ -136,6 +189,20 @@ auto GluaBase::GetGlobal(const std::string& name) -> T
     return val;
 }
 
+template <typename T>
+auto GluaBase::GetGlobalInto(const std::string& name, T& out) -> void
+{
+    pushGlobal(name);
+
+    if (!Is<T>(-1)) {
+        popOffStack(1);
+        throw std::runtime_error("GluaBase::GetGlobalInto with invalid type");
+    }
+
+    AsInto(-1, out);
+    popOffStack(1);
+}
+
 template <typename T>
 auto GluaBase::SetGlobal(const std::string& name, T value) -> void
 {
@@ -150,6 +217,23 @@ auto GluaBase::CreateGluaCallable(Functor&& f) -> Callable
     return createGluaCallableImpl(std::forward<Functor>(f));
 }
 
+template <typename... Functors>
+auto GluaBase::CreateGluaOverloads(Functors&&... functors) -> Callable
+{
+    static_assert(sizeof...(Functors) > 0, "CreateGluaOverloads needs a functor");
+
+    static constexpr std::array<GluaOverloadSignature, sizeof...(Functors)> signatures {
+        glua_overload_signature<std::decay_t<Functors>>()...
+    };
+
+    constexpr auto max_arity = std::max({ std::tuple_size<
+        typename GluaCallableParameters<std::decay_t<Functors>>::type>::value... });
+
+    return Callable { std::make_unique<GluaOverloadedCallable<sizeof...(Functors), max_arity>>(
+        this, signatures.data(),
+        std::array<Callable, sizeof...(Functors)> { CreateGluaCallable(std::forward<Functors>(functors))... }) };
+}
+
 template <typename Method, typename... Methods>
 auto emplace_methods(GluaBase& lua, std::vector<std::unique_ptr<ICallable>>& v,
     Method m, Methods... methods) -> void
@@ -260,6 +344,91 @@ auto GluaBase::RegisterMethod(const std::string& method_name, Callable method)
     }
 }
 
+template <typename ClassType, typename BaseType>
+auto GluaBase::RegisterBaseClass() -> void
+{
+    static_assert(std::is_base_of<BaseType, ClassType>::value,
+        "RegisterBaseClass requires BaseType to be a base of ClassType");
+
+    auto unique_name_opt = getUniqueClassName<ClassType>();
+    auto base_name_opt = getUniqueClassName<BaseType>();
+
+    if (!unique_name_opt.has_value() || !base_name_opt.has_value()) {
+        throw exceptions::LuaException(
+            "Tried to register base class of or to unregistered class [no metatable]");
+    }
+
+    registerBaseClassImpl(unique_name_opt.value(), base_name_opt.value());
+
+    addUpcast(std::type_index { typeid(ClassType) },
+        std::type_index { typeid(BaseType) }, [](void* derived) -> void* {
+            return static_cast<BaseType*>(static_cast<ClassType*>(derived));
+        });
+}
+
+template <typename ClassType>
+auto GluaBase::SetIdentityCacheEnabled(bool enabled) -> void
+{
+    auto unique_name_opt = getUniqueClassName<ClassType>();
+
+    if (unique_name_opt.has_value()) {
+        setIdentityCacheEnabledImpl(unique_name_opt.value(), enabled);
+    } else {
+        throw exceptions::LuaException(
+            "Tried to enable identity cache of unregistered class [no metatable]");
+    }
+}
+
+template <typename ClassType, typename Accessor>
+auto GluaBase::RegisterProperty(const std::string& property_name,
+    Accessor accessor) -> void
+{
+    auto unique_name_opt = getUniqueClassName<ClassType>();
+
+    if (!unique_name_opt.has_value()) {
+        throw exceptions::LuaException(
+            "Tried to register property to unregistered class [no metatable]");
+    }
+
+    if constexpr (std::is_member_object_pointer<Accessor>::value) {
+        using MemberType = std::remove_reference_t<decltype(std::declval<ClassType&>().*std::declval<Accessor>())>;
+        using ValueType = std::remove_cv_t<MemberType>;
+
+        auto getter = CreateGluaCallable(
+            [accessor](const ClassType& object) -> ValueType { return object.*accessor; });
+
+        if constexpr (std::is_const<MemberType>::value) {
+            registerPropertyImpl(unique_name_opt.value(), property_name,
+                std::move(getter), std::nullopt);
+        } else {
+            auto setter = CreateGluaCallable([accessor](ClassType& object, ValueType value) {
+                object.*accessor = std::move(value);
+            });
+
+            registerPropertyImpl(unique_name_opt.value(), property_name,
+                std::move(getter), std::move(setter));
+        }
+    } else {
+        registerPropertyImpl(unique_name_opt.value(), property_name,
+            CreateGluaCallable(accessor), std::nullopt);
+    }
+}
+
+template <typename ClassType, typename Getter, typename Setter>
+auto GluaBase::RegisterProperty(const std::string& property_name,
+    Getter getter, Setter setter) -> void
+{
+    auto unique_name_opt = getUniqueClassName<ClassType>();
+
+    if (unique_name_opt.has_value()) {
+        registerPropertyImpl(unique_name_opt.value(), property_name,
+            CreateGluaCallable(getter), CreateGluaCallable(setter));
+    } else {
+        throw exceptions::LuaException(
+            "Tried to register property to unregistered class [no metatable]");
+    }
+}
+
 template <typename... Params>
 auto GluaBase::CallScriptFunction(const std::string& function_name,
     Params&&... params)
@@ -270,7 +439,9 @@ auto GluaBase::CallScriptFunction(const std::string& function_name,
     // push all params onto the stack
     ((Push(std::forward<Params>(params))), ...);
 
-    callScriptFunctionImpl(function_name, sizeof...(params));
+    // tuple params push one value per element, so count what was pushed
+    callScriptFunctionImpl(function_name,
+        static_cast<size_t>(getStackTop() - previous_top));
 
     auto new_top = getStackTop();
 
@@ -289,6 +460,44 @@ auto GluaBase::CallScriptFunction(const std::string& function_name,
     return results;
 }
 
+template <typename ReturnType, typename... Params>
+auto GluaBase::CallScriptFunctionAs(const std::string& function_name,
+    Params&&... params) -> ReturnType
+{
+    auto previous_top = getStackTop();
+
+    // push all params onto the stack
+    ((Push(std::forward<Params>(params))), ...);
+
+    callScriptFunctionImpl(function_name,
+        static_cast<size_t>(getStackTop() - previous_top));
+
+    auto result_count = static_cast<size_t>(getStackTop() - previous_top);
+
+    if constexpr (std::is_same<ReturnType, void>::value) {
+        popOffStack(result_count);
+    } else {
+        // like in the scripting environment, missing return values are null
+        for (; result_count < GluaValueCount<ReturnType>::value; ++result_count) {
+            push(std::nullopt);
+        }
+
+        auto first_result_index = previous_top + 1;
+
+        if (!Is<ReturnType>(first_result_index)) {
+            popOffStack(result_count);
+            throw std::runtime_error(
+                "GluaBase::CallScriptFunctionAs with invalid return type");
+        }
+
+        auto result = As<ReturnType>(first_result_index);
+
+        popOffStack(result_count);
+
+        return result;
+    }
+}
+
 template <typename T>
 auto GluaBase::getUniqueClassName() const
     -> std::optional<std::reference_wrapper<const std::string>>
@@ -304,6 +513,17 @@ auto GluaBase::getUniqueClassName() const
     return std::nullopt;
 }
 
+template <typename T>
+auto GluaBase::getStoredUserType(IManagedTypeStorage* storage) -> T*
+{
+    if (storage->GetStoredType() == std::type_index { typeid(T) }) {
+        return &static_cast<ManagedTypeStorage<T>*>(storage)->GetStoredValue();
+    }
+
+    // an instance of a registered derived class
+    return static_cast<T*>(upcastUserType(storage, std::type_index { typeid(T) }));
+}
+
 template <typename T>
 auto GluaBase::setUniqueClassName(std::string metatable_name) -> void
 {
@@ -312,6 +532,168 @@ auto GluaBase::setUniqueClassName(std::string metatable_name) -> void
     m_class_to_metatable_name[index] = std::move(metatable_name);
 }
 
+template <typename T>
+auto GluaBase::getInternedStructKeys() -> const std::vector<int>&
+{
+    auto index = std::type_index{ typeid(T) };
+
+    auto pos = m_interned_struct_keys.find(index);
+
+    if (pos != m_interned_struct_keys.end()) {
+        return pos->second;
+    }
+
+    const auto& names = GluaStructFields<T>::names();
+
+    if (names.size() != std::tuple_size<decltype(GluaStructFields<T>::members)>::value) {
+        throw std::logic_error(
+            "GLUA_STRUCT had a different number of field names than members");
+    }
+
+    std::vector<int> keys;
+    keys.reserve(names.size());
+
+    for (const auto& name : names) {
+        keys.push_back(internKey(name));
+    }
+
+    return m_interned_struct_keys.emplace(index, std::move(keys)).first->second;
+}
+
+template <typename T>
+auto GluaBase::getFfiTypeName() -> const std::string&
+{
+    auto index = std::type_index{ typeid(T) };
+
+    auto pos = m_ffi_type_names.find(index);
+
+    if (pos != m_ffi_type_names.end()) {
+        return pos->second;
+    }
+
+    std::string type_name;
+
+    if constexpr (std::is_same<T, bool>::value) {
+        type_name = "bool";
+    } else if constexpr (std::is_integral<T>::value) {
+        type_name = (std::is_signed<T>::value ? "int" : "uint")
+            + std::to_string(sizeof(T) * 8) + "_t";
+    } else if constexpr (std::is_same<T, float>::value) {
+        type_name = "float";
+    } else if constexpr (std::is_same<T, double>::value) {
+        type_name = "double";
+    } else {
+        static_assert(IsGluaStruct<T>::value && std::is_standard_layout<T>::value
+                && std::is_trivially_copyable<T>::value,
+            "FFI types must be integral, float, double or standard layout GLUA_STRUCT types");
+
+        const auto& names = GluaStructFields<T>::names();
+
+        if (names.size() != std::tuple_size<decltype(GluaStructFields<T>::members)>::value) {
+            throw std::logic_error(
+                "GLUA_STRUCT had a different number of field names than members");
+        }
+
+        // the FFI lays fields out in the order they're declared, so they must
+        // be listed in declaration order to match the C++ layout
+        T instance {};
+        std::string cdef = "typedef struct { ";
+        size_t field_index = 0;
+        std::ptrdiff_t previous_offset = -1;
+
+        auto append_field = [&](auto member) {
+            using FieldType = std::decay_t<decltype(instance.*member)>;
+
+            auto offset = reinterpret_cast<const char*>(&(instance.*member))
+                - reinterpret_cast<const char*>(&instance);
+
+            if (offset <= previous_offset) {
+                throw std::logic_error(
+                    "GLUA_STRUCT fields must be listed in declaration order to be used as an FFI type");
+            }
+
+            previous_offset = offset;
+            cdef.append(getFfiTypeName<FieldType>())
+                .append(" ")
+                .append(names[field_index++])
+                .append("; ");
+        };
+
+        std::apply([&](auto... members) { (append_field(members), ...); },
+            GluaStructFields<T>::members);
+
+        type_name = "glua_ffi_struct_" + std::to_string(m_ffi_type_names.size());
+        cdef.append("} ").append(type_name).append(";");
+
+        defineFfiType(type_name, cdef, sizeof(T));
+    }
+
+    return m_ffi_type_names.emplace(index, std::move(type_name)).first->second;
+}
+
+template <typename T>
+auto GluaBase::getFfiSignatureTypeName() -> std::string
+{
+    if constexpr (std::is_void<T>::value) {
+        return "void";
+    } else if constexpr (std::is_pointer<T>::value) {
+        using Pointee = std::remove_pointer_t<T>;
+
+        return (std::is_const<Pointee>::value ? "const " : "")
+            + getFfiTypeName<std::remove_cv_t<Pointee>>() + "*";
+    } else {
+        return getFfiTypeName<std::remove_cv_t<T>>();
+    }
+}
+
+template <typename ReturnType, typename... Params>
+auto GluaBase::RegisterFfiFunction(const std::string& name,
+    ReturnType (*function)(Params...)) -> void
+{
+    // a C function pointer declaration, e.g. double (*)(double, int32_t)
+    auto signature = getFfiSignatureTypeName<ReturnType>() + " (*)(";
+    bool first = true;
+
+    ((signature.append(first ? "" : ", ").append(getFfiSignatureTypeName<Params>()),
+         first = false),
+        ...);
+
+    signature.append(")");
+
+    registerFfiFunctionImpl(name, signature,
+        reinterpret_cast<void*>(function));
+}
+
+template <typename Functor, typename... Params, size_t... Is>
+auto glua_invoke_thunk_functor(GluaBase* glua, Functor& functor,
+    int first_index, std::index_sequence<Is...> /*unused*/) -> int
+{
+    using ReturnType = std::invoke_result_t<Functor&, Params...>;
+
+    // each argument is read by its own index, so evaluation order is irrelevant
+    if constexpr (std::is_void<ReturnType>::value) {
+        functor(glua->Get<Params>(first_index + static_cast<int>(Is))...);
+    } else if constexpr (std::is_reference<ReturnType>::value) {
+        GluaResolver<std::reference_wrapper<std::remove_reference_t<ReturnType>>>::push(
+            glua, std::ref(functor(glua->Get<Params>(first_index + static_cast<int>(Is))...)));
+    } else {
+        GluaResolver<std::decay_t<ReturnType>>::push(
+            glua, functor(glua->Get<Params>(first_index + static_cast<int>(Is))...));
+    }
+
+    return static_cast<int>(GluaValueCount<std::decay_t<ReturnType>>::value);
+}
+
+template <typename Functor, typename... Params>
+auto glua_callable_thunk(GluaBase* glua, void* functor) -> int
+{
+    auto first_index = static_cast<int>(glua->transformFunctionParameterIndex(0));
+
+    return glua_invoke_thunk_functor<Functor, Params...>(glua,
+        *static_cast<Functor*>(functor), first_index,
+        std::index_sequence_for<Params...> {});
+}
+
 template <typename Functor>
 auto GluaBase::createGluaCallableImpl(Functor f) -> Callable
 {
@@ -5,12 +5,32 @@
 // anyway
 #include "glua/GluaBase.h"
 
+#include "glua/ArrayView.h"
+#include "glua/BorrowTable.h"
+#include "glua/FfiBuffer.h"
+
+#include <algorithm>
+#include <array>
 #include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <variant>
 #include <vector>
 
 namespace kdk::glua {
+/**
+ * Resolvers convert between C++ types and values on the glua stack. Besides
+ * `as`, `is` and `push` a resolver may provide `asInto`, which converts into
+ * an existing object so containers can reuse their capacity. Resolvers
+ * without `asInto` are assigned the result of `as`, see GluaBase::AsInto.
+ *
+ * Resolvers may also provide `tryAs`, which checks and converts in one step
+ * and returns nullopt if the value can't be represented, see GluaBase::Get
+ */
 template <typename T>
 struct GluaResolver {
     static auto as(GluaBase* glua, int stack_index) -> T;
@@ -18,6 +38,7 @@ struct GluaResolver {
     static auto push(GluaBase* glua, T value)
         -> void; // base resolver takes by value, specializations may take const
         // references if preferred
+    static auto asInto(GluaBase* glua, int stack_index, T& out) -> void;
 };
 
 template <>
@@ -31,6 +52,7 @@ template <>
 struct GluaResolver<int8_t> {
     static auto as(GluaBase* glua, int stack_index) -> int8_t;
     static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto tryAs(GluaBase* glua, int stack_index) -> std::optional<int8_t>;
     static auto push(GluaBase* glua, int8_t value) -> void;
 };
 
@@ -38,6 +60,7 @@ template <>
 struct GluaResolver<int16_t> {
     static auto as(GluaBase* glua, int stack_index) -> int16_t;
     static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto tryAs(GluaBase* glua, int stack_index) -> std::optional<int16_t>;
     static auto push(GluaBase* glua, int16_t value) -> void;
 };
 
@@ -45,6 +68,7 @@ template <>
 struct GluaResolver<int32_t> {
     static auto as(GluaBase* glua, int stack_index) -> int32_t;
     static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto tryAs(GluaBase* glua, int stack_index) -> std::optional<int32_t>;
     static auto push(GluaBase* glua, int32_t value) -> void;
 };
 
@@ -52,6 +76,7 @@ template <>
 struct GluaResolver<int64_t> {
     static auto as(GluaBase* glua, int stack_index) -> int64_t;
     static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto tryAs(GluaBase* glua, int stack_index) -> std::optional<int64_t>;
     static auto push(GluaBase* glua, int64_t value) -> void;
 };
 
@@ -59,6 +84,7 @@ template <>
 struct GluaResolver<uint8_t> {
     static auto as(GluaBase* glua, int stack_index) -> uint8_t;
     static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto tryAs(GluaBase* glua, int stack_index) -> std::optional<uint8_t>;
     static auto push(GluaBase* glua, uint8_t value) -> void;
 };
 
@@ -66,6 +92,7 @@ template <>
 struct GluaResolver<uint16_t> {
     static auto as(GluaBase* glua, int stack_index) -> uint16_t;
     static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto tryAs(GluaBase* glua, int stack_index) -> std::optional<uint16_t>;
     static auto push(GluaBase* glua, uint16_t value) -> void;
 };
 
@@ -73,6 +100,7 @@ template <>
 struct GluaResolver<uint32_t> {
     static auto as(GluaBase* glua, int stack_index) -> uint32_t;
     static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto tryAs(GluaBase* glua, int stack_index) -> std::optional<uint32_t>;
     static auto push(GluaBase* glua, uint32_t value) -> void;
 };
 
@@ -80,6 +108,7 @@ template <>
 struct GluaResolver<uint64_t> {
     static auto as(GluaBase* glua, int stack_index) -> uint64_t;
     static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto tryAs(GluaBase* glua, int stack_index) -> std::optional<uint64_t>;
     static auto push(GluaBase* glua, uint64_t value) -> void;
 };
 
@@ -87,6 +116,7 @@ template <>
 struct GluaResolver<float> {
     static auto as(GluaBase* glua, int stack_index) -> float;
     static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto tryAs(GluaBase* glua, int stack_index) -> std::optional<float>;
     static auto push(GluaBase* glua, float value) -> void;
 };
 
@@ -94,6 +124,7 @@ template <>
 struct GluaResolver<double> {
     static auto as(GluaBase* glua, int stack_index) -> double;
     static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto tryAs(GluaBase* glua, int stack_index) -> std::optional<double>;
     static auto push(GluaBase* glua, double value) -> void;
 };
 
@@ -101,6 +132,7 @@ template <>
 struct GluaResolver<const char*> {
     static auto as(GluaBase* glua, int stack_index) -> const char*;
     static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto tryAs(GluaBase* glua, int stack_index) -> std::optional<const char*>;
     static auto push(GluaBase* glua, const char* value) -> void;
 };
 
@@ -108,6 +140,7 @@ template <>
 struct GluaResolver<std::string_view> {
     static auto as(GluaBase* glua, int stack_index) -> std::string_view;
     static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto tryAs(GluaBase* glua, int stack_index) -> std::optional<std::string_view>;
     static auto push(GluaBase* glua, std::string_view value) -> void;
 };
 
@@ -115,7 +148,10 @@ template <>
 struct GluaResolver<std::string> {
     static auto as(GluaBase* glua, int stack_index) -> std::string;
     static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto tryAs(GluaBase* glua, int stack_index)
+        -> std::optional<std::string>;
     static auto push(GluaBase* glua, const std::string& value) -> void;
+    static auto asInto(GluaBase* glua, int stack_index, std::string& out) -> void;
 };
 
 template <typename T>
@@ -139,13 +175,63 @@ struct GluaResolver<std::shared_ptr<T>> {
     static auto push(GluaBase* glua, std::shared_ptr<T> value) -> void;
 };
 
+// borrows are only lent to the scripting environment, functions take the
+// object itself by pointer or reference
+template <typename T>
+struct GluaResolver<Borrowed<T>> {
+    static auto push(GluaBase* glua, Borrowed<T> value) -> void;
+};
+
 template <typename T>
 struct GluaResolver<std::vector<T>> {
     static auto as(GluaBase* glua, int stack_index) -> std::vector<T>;
     static auto is(GluaBase* glua, int stack_index) -> bool;
     static auto push(GluaBase* glua, const std::vector<T>& value) -> void;
+    static auto asInto(GluaBase* glua, int stack_index, std::vector<T>& out)
+        -> void;
 };
 
+/**
+ * Fixed size arrays require the array value to have exactly N elements
+ */
+template <typename T, size_t N>
+struct GluaResolver<std::array<T, N>> {
+    static auto as(GluaBase* glua, int stack_index) -> std::array<T, N>;
+    static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto push(GluaBase* glua, const std::array<T, N>& value) -> void;
+    static auto asInto(GluaBase* glua, int stack_index, std::array<T, N>& out)
+        -> void;
+};
+
+/**
+ * Array views accept array values of up to MaxSize elements
+ */
+template <typename T, size_t MaxSize>
+struct GluaResolver<ArrayView<T, MaxSize>> {
+    static auto as(GluaBase* glua, int stack_index) -> ArrayView<T, MaxSize>;
+    static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto push(GluaBase* glua, const ArrayView<T, MaxSize>& value)
+        -> void;
+};
+
+/**
+ * FFI buffers are only supported by backends with an FFI (LuaJIT). Reading one
+ * back gives a buffer without an owner, valid while the value is on the stack
+ */
+template <typename T>
+struct GluaResolver<FfiBuffer<T>> {
+    static auto as(GluaBase* glua, int stack_index) -> FfiBuffer<T>;
+    static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto push(GluaBase* glua, const FfiBuffer<T>& value) -> void;
+};
+
+/**
+ * @return the calling thread's list of the entries string map refills visited,
+ * reused so refilling doesn't allocate once it has grown. A nested refill uses
+ * the part above its enclosing refill's entries
+ */
+auto visited_map_entries() -> std::vector<const void*>&;
+
 template <typename T>
 struct GluaResolver<std::unordered_map<std::string, T>> {
     static auto as(GluaBase* glua, int stack_index)
@@ -153,6 +239,8 @@ struct GluaResolver<std::unordered_map<std::string, T>> {
     static auto is(GluaBase* glua, int stack_index) -> bool;
     static auto push(GluaBase* glua,
         const std::unordered_map<std::string, T>& value) -> void;
+    static auto asInto(GluaBase* glua, int stack_index,
+        std::unordered_map<std::string, T>& out) -> void;
 };
 
 template <typename T>
@@ -160,6 +248,241 @@ struct GluaResolver<std::optional<T>> {
     static auto as(GluaBase* glua, int stack_index) -> std::optional<T>;
     static auto is(GluaBase* glua, int stack_index) -> bool;
     static auto push(GluaBase* glua, const std::optional<T>& value) -> void;
+    static auto asInto(GluaBase* glua, int stack_index, std::optional<T>& out)
+        -> void;
+};
+
+/**
+ * Table views refer to the table where it already is on the stack, nothing is
+ * converted until it's accessed. Pushing a view pushes the table it refers to
+ */
+template <>
+struct GluaResolver<LuaTableView> {
+    static auto as(GluaBase* glua, int stack_index) -> LuaTableView;
+    static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto push(GluaBase* glua, const LuaTableView& value) -> void;
+};
+
+template <>
+struct GluaResolver<std::monostate> {
+    static auto as(GluaBase* glua, int stack_index) -> std::monostate;
+    static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto push(GluaBase* glua, std::monostate value) -> void;
+};
+
+/**
+ * Variants read the value type once and convert directly to the alternative
+ * that has that value type. Only when several alternatives share the value
+ * type (e.g. int32_t and double) are their `is` checks consulted, in order.
+ * If no alternative has the value type, the first alternative the value can
+ * be coerced to is used (e.g. a numeric string to a number)
+ */
+template <typename... Ts>
+struct GluaResolver<std::variant<Ts...>> {
+    static auto as(GluaBase* glua, int stack_index) -> std::variant<Ts...>;
+    static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto push(GluaBase* glua, const std::variant<Ts...>& value) -> void;
+
+private:
+    template <size_t Index>
+    static auto matchingIndex(GluaBase* glua, int stack_index,
+        GluaValueType value_type) -> size_t;
+    template <size_t Index>
+    static auto coercibleIndex(GluaBase* glua, int stack_index) -> size_t;
+    template <size_t Index>
+    static auto asIndex(GluaBase* glua, int stack_index, size_t index)
+        -> std::variant<Ts...>;
+};
+
+/**
+ * Tuples and pairs are not a single value, each element is pushed as its own
+ * value, e.g. as multiple return values. `stack_index` is the index of the
+ * first element, the rest follow it on the stack
+ */
+template <typename... Ts>
+struct GluaResolver<std::tuple<Ts...>> {
+    static auto as(GluaBase* glua, int stack_index) -> std::tuple<Ts...>;
+    static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto push(GluaBase* glua, const std::tuple<Ts...>& value) -> void;
+
+private:
+    template <size_t... Is>
+    static auto asImpl(GluaBase* glua, int stack_index,
+        std::index_sequence<Is...> /*unused*/) -> std::tuple<Ts...>;
+    template <size_t... Is>
+    static auto isImpl(GluaBase* glua, int stack_index,
+        std::index_sequence<Is...> /*unused*/) -> bool;
+};
+
+template <typename First, typename Second>
+struct GluaResolver<std::pair<First, Second>> {
+    static auto as(GluaBase* glua, int stack_index) -> std::pair<First, Second>;
+    static auto is(GluaBase* glua, int stack_index) -> bool;
+    static auto push(GluaBase* glua, const std::pair<First, Second>& value)
+        -> void;
+};
+
+/**
+ * The number of stack values a type occupies when pushed, which is one for
+ * everything but tuples and pairs
+ */
+template <typename T>
+struct GluaValueCount : std::integral_constant<size_t, 1> {
+};
+
+template <>
+struct GluaValueCount<void> : std::integral_constant<size_t, 0> {
+};
+
+template <typename... Ts>
+struct GluaValueCount<std::tuple<Ts...>>
+    : std::integral_constant<size_t, sizeof...(Ts)> {
+};
+
+template <typename First, typename Second>
+struct GluaValueCount<std::pair<First, Second>>
+    : std::integral_constant<size_t, 2> {
+};
+
+/**
+ * Describes the fields of a plain data struct so it can be converted to and
+ * from a script table directly, see GLUA_STRUCT. Specializations provide a
+ * `members` tuple of member pointers and a `names()` list in the same order
+ */
+template <typename T>
+struct GluaStructFields {
+};
+
+template <typename T, typename = void>
+struct IsGluaStruct : std::false_type {
+};
+
+template <typename T>
+struct IsGluaStruct<T, std::void_t<decltype(GluaStructFields<T>::members)>>
+    : std::true_type {
+};
+
+/**
+ * @brief splits the stringified member pointers of GLUA_STRUCT, e.g.
+ * "&Point::x, &Point::y", into the field names "x" and "y"
+ */
+auto parse_struct_field_names(std::string_view member_names)
+    -> std::vector<std::string>;
+
+/**
+ * The value type a C++ type is expected to have on the glua stack, used to
+ * dispatch variants without checking every alternative
+ */
+template <typename T, typename = void>
+struct GluaValueTypeOf
+    : std::integral_constant<GluaValueType,
+          IsGluaStruct<T>::value ? GluaValueType::TABLE : GluaValueType::USERDATA> {
+};
+
+template <typename T>
+struct GluaValueTypeOf<T, std::enable_if_t<std::is_arithmetic<T>::value || std::is_enum<T>::value>>
+    : std::integral_constant<GluaValueType, GluaValueType::NUMBER> {
+};
+
+template <>
+struct GluaValueTypeOf<bool>
+    : std::integral_constant<GluaValueType, GluaValueType::BOOLEAN> {
+};
+
+template <>
+struct GluaValueTypeOf<std::monostate>
+    : std::integral_constant<GluaValueType, GluaValueType::NIL> {
+};
+
+template <>
+struct GluaValueTypeOf<const char*>
+    : std::integral_constant<GluaValueType, GluaValueType::STRING> {
+};
+
+template <>
+struct GluaValueTypeOf<std::string_view>
+    : std::integral_constant<GluaValueType, GluaValueType::STRING> {
+};
+
+template <>
+struct GluaValueTypeOf<std::string>
+    : std::integral_constant<GluaValueType, GluaValueType::STRING> {
+};
+
+template <typename T>
+struct GluaValueTypeOf<std::vector<T>>
+    : std::integral_constant<GluaValueType, GluaValueType::TABLE> {
+};
+
+template <typename T, size_t N>
+struct GluaValueTypeOf<std::array<T, N>>
+    : std::integral_constant<GluaValueType, GluaValueType::TABLE> {
+};
+
+template <typename T, size_t MaxSize>
+struct GluaValueTypeOf<ArrayView<T, MaxSize>>
+    : std::integral_constant<GluaValueType, GluaValueType::TABLE> {
+};
+
+template <typename T>
+struct GluaValueTypeOf<std::unordered_map<std::string, T>>
+    : std::integral_constant<GluaValueType, GluaValueType::TABLE> {
+};
+
+// FFI cdata has no type of its own in the Lua C API
+template <typename T>
+struct GluaValueTypeOf<FfiBuffer<T>>
+    : std::integral_constant<GluaValueType, GluaValueType::OTHER> {
+};
+
+template <>
+struct GluaValueTypeOf<LuaTableView>
+    : std::integral_constant<GluaValueType, GluaValueType::TABLE> {
+};
+
+template <typename T>
+struct GluaValueTypeOf<std::optional<T>> : GluaValueTypeOf<T> {
+};
+
+/**
+ * The value types a C++ type accepts on the glua stack as a mask with bit
+ * `1 << GluaValueType` set for each, used to dispatch overloads
+ */
+template <typename T>
+struct GluaValueTypeMask
+    : std::integral_constant<unsigned, 1u << static_cast<unsigned>(GluaValueTypeOf<T>::value)> {
+};
+
+template <typename T>
+struct GluaValueTypeMask<std::optional<T>>
+    : std::integral_constant<unsigned,
+          GluaValueTypeMask<T>::value | 1u << static_cast<unsigned>(GluaValueType::NIL)> {
+};
+
+template <typename... Ts>
+struct GluaValueTypeMask<std::variant<Ts...>>
+    : std::integral_constant<unsigned, (GluaValueTypeMask<Ts>::value | ...)> {
+};
+
+template <typename T, typename = void>
+struct HasAsInto : std::false_type {
+};
+
+template <typename T>
+struct HasAsInto<T,
+    std::void_t<decltype(GluaResolver<T>::asInto(
+        std::declval<GluaBase*>(), 0, std::declval<T&>()))>>
+    : std::true_type {
+};
+
+template <typename T, typename = void>
+struct HasTryAs : std::false_type {
+};
+
+template <typename T>
+struct HasTryAs<T,
+    std::void_t<decltype(GluaResolver<T>::tryAs(std::declval<GluaBase*>(), 0))>>
+    : std::true_type {
 };
 
 template <typename T, typename = void>
@@ -10,15 +10,41 @@ auto GluaResolver<T>::as(GluaBase* glua, int stack_index) -> T
 
     if constexpr (std::is_enum<RawT>::value) {
         return static_cast<T>(GluaResolver<uint64_t>::as(glua, stack_index));
+    } else if constexpr (IsGluaStruct<RawT>::value) {
+        static_assert(!std::is_reference<T>::value,
+            "GLUA_STRUCT types are converted by value, take them by value");
+
+        if (!glua->isMap(stack_index)) {
+            throw exceptions::GluaTypeException(
+                "Value is not a table of the requested struct type");
+        }
+
+        const auto& keys = glua->getInternedStructKeys<RawT>();
+        size_t key_index = 0;
+
+        RawT result {};
+
+        auto get_field = [&](auto member) {
+            using FieldType = std::decay_t<decltype(result.*member)>;
+
+            // pushes the field value onto the stack
+            glua->getInternedMapValue(keys[key_index++], stack_index);
+            result.*member = GluaResolver<FieldType>::as(glua, -1);
+            glua->popOffStack(1);
+        };
+
+        std::apply([&](auto... members) { (get_field(members), ...); },
+            GluaStructFields<RawT>::members);
+
+        return result;
     } else {
         auto unique_name_opt = glua->getUniqueClassName<RawT>();
 
         if (unique_name_opt.has_value()) {
-            auto storage_ptr = static_cast<ManagedTypeStorage<RawT>*>(
-                glua->getUserType(unique_name_opt.value(), stack_index));
+            auto storage_ptr = glua->getUserType(unique_name_opt.value(), stack_index);
 
             if (storage_ptr) {
-                return storage_ptr->GetStoredValue();
+                return *glua->getStoredUserType<RawT>(storage_ptr);
             }
 
             // all above cases return, so type must be unregistered
@@ -40,6 +66,8 @@ auto GluaResolver<T>::is(GluaBase* glua, int stack_index) -> bool
 
     if constexpr (std::is_enum<RawT>::value) {
         return GluaResolver<uint64_t>::is(glua, stack_index);
+    } else if constexpr (IsGluaStruct<RawT>::value) {
+        return glua->isMap(stack_index);
     } else {
         auto unique_name_opt = glua->getUniqueClassName<RawT>();
 
@@ -59,6 +87,22 @@ auto GluaResolver<T>::push(GluaBase* glua, T value) -> void
 
     if constexpr (std::is_enum<RawT>::value) {
         GluaResolver<uint64_t>::push(glua, static_cast<uint64_t>(value));
+    } else if constexpr (IsGluaStruct<RawT>::value) {
+        const auto& keys = glua->getInternedStructKeys<RawT>();
+        size_t key_index = 0;
+
+        glua->pushStartMap(keys.size());
+
+        auto push_field = [&](auto member) {
+            using FieldType = std::decay_t<decltype(value.*member)>;
+
+            glua->pushInternedKey(keys[key_index++]);
+            GluaResolver<FieldType>::push(glua, value.*member);
+            glua->mapSetFromStack();
+        };
+
+        std::apply([&](auto... members) { (push_field(members), ...); },
+            GluaStructFields<RawT>::members);
     } else {
         auto unique_name_opt = glua->getUniqueClassName<RawT>();
 
@@ -74,6 +118,34 @@ auto GluaResolver<T>::push(GluaBase* glua, T value) -> void
     }
 }
 
+template <typename T>
+auto GluaResolver<T>::asInto(GluaBase* glua, int stack_index, T& out) -> void
+{
+    using RawT = std::decay_t<T>;
+
+    if constexpr (IsGluaStruct<RawT>::value) {
+        if (!glua->isMap(stack_index)) {
+            throw exceptions::GluaTypeException(
+                "Value is not a table of the requested struct type");
+        }
+
+        const auto& keys = glua->getInternedStructKeys<RawT>();
+        size_t key_index = 0;
+
+        auto get_field = [&](auto member) {
+            // pushes the field value onto the stack
+            glua->getInternedMapValue(keys[key_index++], stack_index);
+            glua->AsInto(-1, out.*member);
+            glua->popOffStack(1);
+        };
+
+        std::apply([&](auto... members) { (get_field(members), ...); },
+            GluaStructFields<RawT>::members);
+    } else {
+        out = as(glua, stack_index);
+    }
+}
+
 template <typename T>
 auto GluaResolver<T*>::as(GluaBase* glua, int stack_index) -> T*
 {
@@ -85,11 +157,10 @@ auto GluaResolver<T*>::as(GluaBase* glua, int stack_index) -> T*
         auto unique_name_opt = glua->getUniqueClassName<RawT>();
 
         if (unique_name_opt.has_value()) {
-            auto storage_ptr = static_cast<ManagedTypeStorage<RawT>*>(
-                glua->getUserType(unique_name_opt.value(), stack_index));
+            auto storage_ptr = glua->getUserType(unique_name_opt.value(), stack_index);
 
             if (storage_ptr) {
-                return &storage_ptr->GetStoredValue();
+                return glua->getStoredUserType<RawT>(storage_ptr);
             }
 
             // all above cases return, so type must be unregistered
@@ -132,6 +203,10 @@ auto GluaResolver<T*>::push(GluaBase* glua, T* value) -> void
         auto unique_name_opt = glua->getUniqueClassName<RawT>();
 
         if (unique_name_opt.has_value()) {
+            if (glua->pushCachedUserType(unique_name_opt.value(), value, false)) {
+                return;
+            }
+
             // create storage, hand off to implementation
             glua->pushUserType(unique_name_opt.value(),
                 std::make_unique<ManagedTypeRawPtr<RawT>>(value));
@@ -151,15 +226,23 @@ auto GluaResolver<std::reference_wrapper<T>>::as(GluaBase* glua,
 
     if constexpr (std::is_enum<RawT>::value) {
         return static_cast<T>(GluaResolver<uint64_t>::as(glua, stack_index));
+    } else if constexpr (IsProxiedContainer<RawT>::value) {
+        auto proxy = glua->getContainerProxy(stack_index);
+
+        if (proxy && proxy->GetContainerType() == std::type_index { typeid(RawT) }) {
+            return std::ref(*static_cast<RawT*>(proxy->GetContainer()));
+        }
+
+        throw exceptions::GluaBaseException(
+            "Failed to get container reference, value is not a proxy of the requested container type");
     } else {
         auto unique_name_opt = glua->getUniqueClassName<RawT>();
 
         if (unique_name_opt.has_value()) {
-            auto storage_ptr = static_cast<ManagedTypeStorage<RawT>*>(
-                glua->getUserType(unique_name_opt.value(), stack_index));
+            auto storage_ptr = glua->getUserType(unique_name_opt.value(), stack_index);
 
             if (storage_ptr) {
-                return std::ref(storage_ptr->GetStoredValue());
+                return std::ref(*glua->getStoredUserType<RawT>(storage_ptr));
             }
 
             // all above cases return, so type must be unregistered
@@ -181,6 +264,10 @@ auto GluaResolver<std::reference_wrapper<T>>::is(GluaBase* glua,
 
     if constexpr (std::is_enum<RawT>::value) {
         return GluaResolver<uint64_t>::is(glua, stack_index);
+    } else if constexpr (IsProxiedContainer<RawT>::value) {
+        auto proxy = glua->getContainerProxy(stack_index);
+
+        return proxy && proxy->GetContainerType() == std::type_index { typeid(RawT) };
     } else {
         auto unique_name_opt = glua->getUniqueClassName<RawT>();
 
@@ -205,10 +292,19 @@ auto GluaResolver<std::reference_wrapper<T>>::push(
     } else {
         if constexpr (std::is_enum<RawT>::value) {
             GluaResolver<uint64_t>::push(glua, static_cast<uint64_t>(value));
+        } else if constexpr (IsProxiedContainer<RawT>::value) {
+            // containers are exposed by reference through a proxy, the caller
+            // guarantees the container outlives it
+            glua->pushContainerProxy(
+                std::make_unique<ContainerProxy<RawT, RawT*>>(&value.get()));
         } else {
             auto unique_name_opt = glua->getUniqueClassName<RawT>();
 
             if (unique_name_opt.has_value()) {
+                if (glua->pushCachedUserType(unique_name_opt.value(), &value.get(), false)) {
+                    return;
+                }
+
                 // create storage, hand off to implementation
                 glua->pushUserType(unique_name_opt.value(),
                     std::make_unique<ManagedTypeRawPtr<RawT>>(
@@ -230,19 +326,34 @@ auto GluaResolver<std::shared_ptr<T>>::as(GluaBase* glua, int stack_index)
 
     if constexpr (std::is_enum<RawT>::value) {
         return static_cast<T>(GluaResolver<uint64_t>::as(glua, stack_index));
+    } else if constexpr (IsProxiedContainer<RawT>::value) {
+        auto proxy = dynamic_cast<ContainerProxy<RawT, std::shared_ptr<RawT>>*>(
+            glua->getContainerProxy(stack_index));
+
+        if (proxy) {
+            return proxy->GetHolder();
+        }
+
+        throw exceptions::GluaBaseException(
+            "Failed to get container as shared_ptr, value is not a shared proxy of the requested container type");
     } else {
         auto unique_name_opt = glua->getUniqueClassName<RawT>();
 
         if (unique_name_opt.has_value()) {
-            auto storage_ptr = static_cast<ManagedTypeStorage<RawT>*>(
-                glua->getUserType(unique_name_opt.value(), stack_index));
+            auto storage_ptr = glua->getUserType(unique_name_opt.value(), stack_index);
 
             if (storage_ptr) {
                 // shared_ptr is a special case where it must specifically have
                 // shared_ptr storage
                 if (storage_ptr->GetStorageType() == ManagedTypeStorageType::SHARED_PTR) {
-                    return static_cast<ManagedTypeSharedPtr<RawT>*>(storage_ptr)
-                        ->GetValue();
+                    if (storage_ptr->GetStoredType() == std::type_index { typeid(RawT) }) {
+                        return static_cast<ManagedTypeSharedPtr<RawT>*>(storage_ptr)
+                            ->GetValue();
+                    }
+
+                    // a derived instance, share its ownership through the base
+                    return std::shared_ptr<RawT> { storage_ptr->GetSharedOwner(),
+                        glua->getStoredUserType<RawT>(storage_ptr) };
                 }
 
                 throw exceptions::GluaBaseException(
@@ -271,6 +382,10 @@ auto GluaResolver<std::shared_ptr<T>>::is(GluaBase* glua, int stack_index)
 
     if constexpr (std::is_enum<RawT>::value) {
         return GluaResolver<uint64_t>::is(glua, stack_index);
+    } else if constexpr (IsProxiedContainer<RawT>::value) {
+        return dynamic_cast<ContainerProxy<RawT, std::shared_ptr<RawT>>*>(
+                   glua->getContainerProxy(stack_index))
+            != nullptr;
     } else {
         auto unique_name_opt = glua->getUniqueClassName<RawT>();
 
@@ -290,10 +405,19 @@ auto GluaResolver<std::shared_ptr<T>>::push(GluaBase* glua,
 
     if constexpr (std::is_enum<RawT>::value) {
         GluaResolver<uint64_t>::push(glua, static_cast<uint64_t>(value));
+    } else if constexpr (IsProxiedContainer<RawT>::value) {
+        // the proxy shares ownership of the container
+        glua->pushContainerProxy(
+            std::make_unique<ContainerProxy<RawT, std::shared_ptr<RawT>>>(
+                std::move(value)));
     } else {
         auto unique_name_opt = glua->getUniqueClassName<RawT>();
 
         if (unique_name_opt.has_value()) {
+            if (glua->pushCachedUserType(unique_name_opt.value(), value.get(), true)) {
+                return;
+            }
+
             // create storage, hand off to implementation
             glua->pushUserType(unique_name_opt.value(),
                 std::make_unique<ManagedTypeSharedPtr<RawT>>(value));
@@ -304,6 +428,21 @@ auto GluaResolver<std::shared_ptr<T>>::push(GluaBase* glua,
     }
 }
 
+template <typename T>
+auto GluaResolver<Borrowed<T>>::push(GluaBase* glua, Borrowed<T> value) -> void
+{
+    auto unique_name_opt = glua->getUniqueClassName<T>();
+
+    if (!unique_name_opt.has_value()) {
+        throw exceptions::GluaBaseException(
+            "Attempted to push unregistered type");
+    }
+
+    // never looked up in the identity cache, every borrow is its own userdata
+    glua->pushUserType(unique_name_opt.value(),
+        std::make_unique<ManagedTypeBorrowed<T>>(std::move(value)));
+}
+
 template <typename T>
 auto GluaResolver<std::vector<T>>::as(GluaBase* glua, int stack_index)
     -> std::vector<T>
@@ -325,6 +464,32 @@ auto GluaResolver<std::vector<T>>::as(GluaBase* glua, int stack_index)
     return result;
 }
 template <typename T>
+auto GluaResolver<std::vector<T>>::asInto(GluaBase* glua, int stack_index,
+    std::vector<T>& out) -> void
+{
+    auto count = glua->getArraySize(stack_index);
+
+    if constexpr (std::is_default_constructible<T>::value) {
+        // existing elements are converted into, keeping their own capacity
+        out.resize(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            glua->getArrayValue(glua->transformObjectIndex(i), stack_index);
+            glua->AsInto(-1, out[i]);
+            glua->popOffStack(1);
+        }
+    } else {
+        out.clear();
+        out.reserve(count);
+
+        for (size_t i = 0; i < count; ++i) {
+            glua->getArrayValue(glua->transformObjectIndex(i), stack_index);
+            out.push_back(GluaResolver<T>::as(glua, -1));
+            glua->popOffStack(1);
+        }
+    }
+}
+template <typename T>
 auto GluaResolver<std::vector<T>>::is(GluaBase* glua, int stack_index) -> bool
 {
     return glua->isArray(stack_index);
@@ -343,6 +508,132 @@ auto GluaResolver<std::vector<T>>::push(GluaBase* glua,
     }
 }
 
+template <typename T, size_t N>
+auto GluaResolver<std::array<T, N>>::as(GluaBase* glua, int stack_index)
+    -> std::array<T, N>
+{
+    auto count = glua->getArraySize(stack_index);
+
+    if (count != N) {
+        throw exceptions::GluaTypeException(
+            "Array of length " + std::to_string(count) + " where std::array of length "
+            + std::to_string(N) + " was expected");
+    }
+
+    std::array<T, N> result {};
+
+    for (size_t i = 0; i < N; ++i) {
+        glua->getArrayValue(glua->transformObjectIndex(i), stack_index);
+        result[i] = GluaResolver<T>::as(glua, -1);
+        glua->popOffStack(1);
+    }
+
+    return result;
+}
+template <typename T, size_t N>
+auto GluaResolver<std::array<T, N>>::asInto(GluaBase* glua, int stack_index,
+    std::array<T, N>& out) -> void
+{
+    auto count = glua->getArraySize(stack_index);
+
+    if (count != N) {
+        throw exceptions::GluaTypeException(
+            "Array of length " + std::to_string(count) + " where std::array of length "
+            + std::to_string(N) + " was expected");
+    }
+
+    for (size_t i = 0; i < N; ++i) {
+        glua->getArrayValue(glua->transformObjectIndex(i), stack_index);
+        glua->AsInto(-1, out[i]);
+        glua->popOffStack(1);
+    }
+}
+template <typename T, size_t N>
+auto GluaResolver<std::array<T, N>>::is(GluaBase* glua, int stack_index) -> bool
+{
+    return glua->isArray(stack_index) && glua->getArraySize(stack_index) == N;
+}
+template <typename T, size_t N>
+auto GluaResolver<std::array<T, N>>::push(GluaBase* glua,
+    const std::array<T, N>& value) -> void
+{
+    glua->pushArray(N);
+
+    for (size_t i = 0; i < N; ++i) {
+        GluaResolver<size_t>::push(glua, glua->transformObjectIndex(i));
+        GluaResolver<T>::push(glua, value[i]);
+        glua->arraySetFromStack();
+    }
+}
+
+template <typename T, size_t MaxSize>
+auto GluaResolver<ArrayView<T, MaxSize>>::as(GluaBase* glua, int stack_index)
+    -> ArrayView<T, MaxSize>
+{
+    auto count = glua->getArraySize(stack_index);
+
+    if (count > MaxSize) {
+        throw exceptions::GluaTypeException(
+            "Array of length " + std::to_string(count) + " exceeds ArrayView capacity of "
+            + std::to_string(MaxSize));
+    }
+
+    ArrayView<T, MaxSize> result;
+
+    for (size_t i = 0; i < count; ++i) {
+        glua->getArrayValue(glua->transformObjectIndex(i), stack_index);
+        result.PushBack(GluaResolver<T>::as(glua, -1));
+        glua->popOffStack(1);
+    }
+
+    return result;
+}
+template <typename T, size_t MaxSize>
+auto GluaResolver<ArrayView<T, MaxSize>>::is(GluaBase* glua, int stack_index)
+    -> bool
+{
+    return glua->isArray(stack_index) && glua->getArraySize(stack_index) <= MaxSize;
+}
+template <typename T, size_t MaxSize>
+auto GluaResolver<ArrayView<T, MaxSize>>::push(GluaBase* glua,
+    const ArrayView<T, MaxSize>& value) -> void
+{
+    auto size = value.size();
+    glua->pushArray(size);
+
+    for (size_t i = 0; i < size; ++i) {
+        GluaResolver<size_t>::push(glua, glua->transformObjectIndex(i));
+        GluaResolver<T>::push(glua, value[i]);
+        glua->arraySetFromStack();
+    }
+}
+
+template <typename T>
+auto GluaResolver<FfiBuffer<T>>::as(GluaBase* glua, int stack_index)
+    -> FfiBuffer<T>
+{
+    auto buffer = glua->getFfiBuffer(glua->getFfiTypeName<T>(), stack_index);
+
+    if (!buffer.has_value()) {
+        throw exceptions::GluaTypeException(
+            "Value is not an FFI buffer of the requested element type");
+    }
+
+    return FfiBuffer<T> { static_cast<T*>(buffer->first), buffer->second };
+}
+template <typename T>
+auto GluaResolver<FfiBuffer<T>>::is(GluaBase* glua, int stack_index) -> bool
+{
+    return glua->getFfiBuffer(glua->getFfiTypeName<T>(), stack_index).has_value();
+}
+template <typename T>
+auto GluaResolver<FfiBuffer<T>>::push(GluaBase* glua,
+    const FfiBuffer<T>& value) -> void
+{
+    glua->pushFfiBuffer(glua->getFfiTypeName<T>(), value.Data(), value.Size(),
+        value.GetOwner());
+}
+
 template <typename T>
 auto GluaResolver<std::unordered_map<std::string, T>>::as(GluaBase* glua,
     int stack_index)
@@ -364,6 +655,84 @@ auto GluaResolver<std::unordered_map<std::string, T>>::as(GluaBase* glua,
     return result;
 }
 template <typename T>
+auto GluaResolver<std::unordered_map<std::string, T>>::asInto(GluaBase* glua,
+    int stack_index, std::unordered_map<std::string, T>& out) -> void
+{
+    auto absolute_map_index = glua->absoluteStackIndex(stack_index);
+
+    std::string key;
+    auto had_entries = !out.empty();
+    auto has_converted_keys = false;
+
+    // entries of the previous contents which the table still has, only
+    // tracked when there are previous contents to remove. Map nodes are
+    // stable, so their keys' addresses identify them
+    struct VisitedScope {
+        std::vector<const void*>& entries;
+        size_t start;
+
+        ~VisitedScope() { entries.resize(start); }
+    } visited { visited_map_entries(), visited_map_entries().size() };
+
+    // null key starts the iteration
+    glua->push(std::nullopt);
+
+    while (glua->nextMapEntry(absolute_map_index)) {
+        // key is now at -2 and value at -1
+        if (glua->getValueType(-2) == GluaValueType::STRING) {
+            key.assign(glua->getStringView(-2));
+        } else {
+            // converting a non-string key in place would break iteration,
+            // convert a copy instead
+            glua->pushValueCopy(-2);
+            key.assign(glua->getStringView(-1));
+            glua->popOffStack(1);
+            has_converted_keys = true;
+        }
+
+        auto pos = out.find(key);
+
+        if (pos != out.end()) {
+            glua->AsInto(-1, pos->second);
+        } else {
+            pos = out.emplace(key, GluaResolver<T>::as(glua, -1)).first;
+        }
+
+        if (had_entries) {
+            visited.entries.push_back(&pos->first);
+        }
+
+        // pop the value, leaving the key for the next iteration
+        glua->popOffStack(1);
+    }
+
+    if (!had_entries) {
+        return;
+    }
+
+    // string keys are unique, so unless a converted key repeated one every
+    // entry was visited once when the counts match
+    auto first = visited.entries.begin() + static_cast<std::ptrdiff_t>(visited.start);
+    auto visited_count = static_cast<size_t>(visited.entries.end() - first);
+
+    if (!has_converted_keys && visited_count == out.size()) {
+        return;
+    }
+
+    std::sort(first, visited.entries.end(), std::less<const void*> {});
+    auto last = std::unique(first, visited.entries.end());
+
+    // remove entries left over from the previous contents
+    for (auto pos = out.begin(); pos != out.end();) {
+        if (!std::binary_search(first, last, static_cast<const void*>(&pos->first),
+                std::less<const void*> {})) {
+            pos = out.erase(pos);
+        } else {
+            ++pos;
+        }
+    }
+}
+template <typename T>
 auto GluaResolver<std::unordered_map<std::string, T>>::is(GluaBase* glua,
     int stack_index)
     -> bool
@@ -394,6 +763,18 @@ auto GluaResolver<std::optional<T>>::as(GluaBase* glua, int stack_index)
     return GluaResolver<T>::as(glua, stack_index);
 }
 template <typename T>
+auto GluaResolver<std::optional<T>>::asInto(GluaBase* glua, int stack_index,
+    std::optional<T>& out) -> void
+{
+    if (glua->isNull(stack_index)) {
+        out.reset();
+    } else if (out.has_value()) {
+        glua->AsInto(stack_index, out.value());
+    } else {
+        out = GluaResolver<T>::as(glua, stack_index);
+    }
+}
+template <typename T>
 auto GluaResolver<std::optional<T>>::is(GluaBase* glua, int stack_index)
     -> bool
 {
@@ -411,4 +792,158 @@ auto GluaResolver<std::optional<T>>::push(GluaBase* glua,
     }
 }
 
+template <typename... Ts>
+auto GluaResolver<std::tuple<Ts...>>::as(GluaBase* glua, int stack_index)
+    -> std::tuple<Ts...>
+{
+    return asImpl(glua, stack_index, std::index_sequence_for<Ts...> {});
+}
+template <typename... Ts>
+auto GluaResolver<std::tuple<Ts...>>::is(GluaBase* glua, int stack_index)
+    -> bool
+{
+    return isImpl(glua, stack_index, std::index_sequence_for<Ts...> {});
+}
+template <typename... Ts>
+auto GluaResolver<std::tuple<Ts...>>::push(GluaBase* glua,
+    const std::tuple<Ts...>& value) -> void
+{
+    std::apply(
+        [glua](const auto&... elements) {
+            (GluaResolver<std::decay_t<decltype(elements)>>::push(glua, elements),
+                ...);
+        },
+        value);
+}
+template <typename... Ts>
+template <size_t... Is>
+auto GluaResolver<std::tuple<Ts...>>::asImpl(GluaBase* glua, int stack_index,
+    std::index_sequence<Is...> /*unused*/) -> std::tuple<Ts...>
+{
+    // braced initialization guarantees the elements are read in order
+    return std::tuple<Ts...> { GluaResolver<Ts>::as(
+        glua, stack_index + static_cast<int>(Is))... };
+}
+template <typename... Ts>
+template <size_t... Is>
+auto GluaResolver<std::tuple<Ts...>>::isImpl(GluaBase* glua, int stack_index,
+    std::index_sequence<Is...> /*unused*/) -> bool
+{
+    return (GluaResolver<Ts>::is(glua, stack_index + static_cast<int>(Is)) && ...);
+}
+
+template <typename First, typename Second>
+auto GluaResolver<std::pair<First, Second>>::as(GluaBase* glua,
+    int stack_index) -> std::pair<First, Second>
+{
+    return std::pair<First, Second> { GluaResolver<First>::as(glua, stack_index),
+        GluaResolver<Second>::as(glua, stack_index + 1) };
+}
+template <typename First, typename Second>
+auto GluaResolver<std::pair<First, Second>>::is(GluaBase* glua,
+    int stack_index) -> bool
+{
+    return GluaResolver<First>::is(glua, stack_index)
+        && GluaResolver<Second>::is(glua, stack_index + 1);
+}
+template <typename First, typename Second>
+auto GluaResolver<std::pair<First, Second>>::push(GluaBase* glua,
+    const std::pair<First, Second>& value) -> void
+{
+    GluaResolver<std::decay_t<First>>::push(glua, value.first);
+    GluaResolver<std::decay_t<Second>>::push(glua, value.second);
+}
+
+template <typename... Ts>
+auto GluaResolver<std::variant<Ts...>>::as(GluaBase* glua, int stack_index)
+    -> std::variant<Ts...>
+{
+    auto index = matchingIndex<0>(glua, stack_index, glua->getValueType(stack_index));
+
+    if (index < sizeof...(Ts)) {
+        return asIndex<0>(glua, stack_index, index);
+    }
+
+    throw exceptions::GluaTypeException(
+        "Value did not match any alternative of std::variant");
+}
+template <typename... Ts>
+auto GluaResolver<std::variant<Ts...>>::is(GluaBase* glua, int stack_index)
+    -> bool
+{
+    return matchingIndex<0>(glua, stack_index, glua->getValueType(stack_index))
+        < sizeof...(Ts);
+}
+template <typename... Ts>
+auto GluaResolver<std::variant<Ts...>>::push(GluaBase* glua,
+    const std::variant<Ts...>& value) -> void
+{
+    std::visit(
+        [glua](const auto& alternative) {
+            GluaResolver<std::decay_t<decltype(alternative)>>::push(glua,
+                alternative);
+        },
+        value);
+}
+template <typename... Ts>
+template <size_t Index>
+auto GluaResolver<std::variant<Ts...>>::matchingIndex(GluaBase* glua,
+    int stack_index, GluaValueType value_type) -> size_t
+{
+    if constexpr (Index < sizeof...(Ts)) {
+        using Alternative = std::variant_alternative_t<Index, std::variant<Ts...>>;
+        constexpr auto alternative_type = GluaValueTypeOf<Alternative>::value;
+        constexpr auto same_type_count = ((GluaValueTypeOf<Ts>::value == alternative_type ? 1 : 0) + ...);
+
+        if (alternative_type == value_type) {
+            // the only alternative of this value type needs no further checks,
+            // except for userdata which are only told apart by their class
+            if constexpr (same_type_count == 1 && alternative_type != GluaValueType::USERDATA) {
+                return Index;
+            } else {
+                if (GluaResolver<Alternative>::is(glua, stack_index)) {
+                    return Index;
+                }
+            }
+        }
+
+        return matchingIndex<Index + 1>(glua, stack_index, value_type);
+    } else {
+        return coercibleIndex<0>(glua, stack_index);
+    }
+}
+template <typename... Ts>
+template <size_t Index>
+auto GluaResolver<std::variant<Ts...>>::coercibleIndex(GluaBase* glua,
+    int stack_index) -> size_t
+{
+    if constexpr (Index < sizeof...(Ts)) {
+        using Alternative = std::variant_alternative_t<Index, std::variant<Ts...>>;
+
+        if (GluaResolver<Alternative>::is(glua, stack_index)) {
+            return Index;
+        }
+
+        return coercibleIndex<Index + 1>(glua, stack_index);
+    } else {
+        return sizeof...(Ts);
+    }
+}
+template <typename... Ts>
+template <size_t Index>
+auto GluaResolver<std::variant<Ts...>>::asIndex(GluaBase* glua,
+    int stack_index, size_t index) -> std::variant<Ts...>
+{
+    using Alternative = std::variant_alternative_t<Index, std::variant<Ts...>>;
+
+    if constexpr (Index + 1 < sizeof...(Ts)) {
+        if (index != Index) {
+            return asIndex<Index + 1>(glua, stack_index, index);
+        }
+    }
+
+    return std::variant<Ts...> { std::in_place_index<Index>,
+        GluaResolver<Alternative>::as(glua, stack_index) };
+}
+
 } // namespace kdk::glua
@@ -7,8 +7,54 @@
 namespace kdk::glua {
 class GluaBase;
 
+/**
+ * A bound function's entry point, generated per signature. It converts the
+ * arguments from the stack straight into the call of the functor at
+ * `functor`, pushes its return value and returns the number of values pushed,
+ * which is known at compile time
+ */
+using GluaThunkFunction = int (*)(GluaBase* glua, void* functor);
+
+/**
+ * What a backend needs to call a functor through its thunk from storage the
+ * backend owns, e.g. a userdata upvalue of the function it registers
+ */
+struct GluaThunk {
+    GluaThunkFunction call;
+    void (*destroy_functor)(void* functor);
+    size_t functor_size;
+    size_t functor_alignment;
+};
+
+/**
+ * Implemented by callables that can hand their functor over to be called
+ * through a GluaThunk instead of ICallable::Call
+ */
+class IGluaThunkCallable {
+public:
+    virtual auto GetThunk() const -> GluaThunk = 0;
+    /**
+   * @brief move constructs the functor into `destination`, which has the size
+   * and alignment given by GetThunk. The callable must not be called
+   * afterwards
+   */
+    virtual auto MoveFunctorTo(void* destination) -> void = 0;
+
+    virtual ~IGluaThunkCallable() = default;
+    IGluaThunkCallable() = default;
+    IGluaThunkCallable(const IGluaThunkCallable&) = default;
+    IGluaThunkCallable(IGluaThunkCallable&&) noexcept = default;
+
+    auto operator=(const IGluaThunkCallable&) -> IGluaThunkCallable& = default;
+    auto operator=(IGluaThunkCallable&&) noexcept -> IGluaThunkCallable& = default;
+};
+
 template <typename Functor, typename... Params>
-class GluaCallable : public DeferredArgumentCallable<GluaBase, Functor, Params...> {
+auto glua_callable_thunk(GluaBase* glua, void* functor) -> int;
+
+template <typename Functor, typename... Params>
+class GluaCallable : public DeferredArgumentCallable<GluaBase, Functor, Params...>,
+                     public IGluaThunkCallable {
 public:
     GluaCallable(GluaBase* glua, Functor functor);
     GluaCallable(const GluaCallable&) = default;
@@ -20,6 +66,9 @@ public:
     auto GetGlua() const -> GluaBase*;
     auto GetImplementationData() const -> void* override;
 
+    auto GetThunk() const -> GluaThunk override;
+    auto MoveFunctorTo(void* destination) -> void override;
+
     ~GluaCallable() override = default;
 
 private:
@@ -2,6 +2,8 @@
 
 #include "glua/GluaCallable.h"
 
+#include <new>
+
 namespace kdk::glua {
 template <typename Functor, typename... Params>
 GluaCallable<Functor, Params...>::GluaCallable(GluaBase* glua, Functor functor)
@@ -22,4 +24,21 @@ auto GluaCallable<Functor, Params...>::GetImplementationData() const -> void*
     return m_glua;
 }
 
+template <typename Functor, typename... Params>
+auto GluaCallable<Functor, Params...>::GetThunk() const -> GluaThunk
+{
+    auto destroy_functor = [](void* functor) {
+        static_cast<Functor*>(functor)->~Functor();
+    };
+
+    return GluaThunk { &glua_callable_thunk<Functor, Params...>, destroy_functor,
+        sizeof(Functor), alignof(Functor) };
+}
+
+template <typename Functor, typename... Params>
+auto GluaCallable<Functor, Params...>::MoveFunctorTo(void* destination) -> void
+{
+    new (destination) Functor(std::move(this->GetFunctor()));
+}
+
 } // namespace kdk::glua
@@ -1,24 +1,32 @@
 #pragma once
 
-#include "glua/GluaBase.h"
-
-extern "C" {
-#include "lauxlib.h"
-#include "lua.h"
-#include "lualib.h"
-}
+#include "glua/GluaLuaCommon.h"
+#include "glua/JitDiagnostics.h"
 
 namespace kdk::glua {
-struct LuaStateDeleter {
-    auto operator()(lua_State* state) -> void;
+/**
+ * How 64 bit integers are pushed to Lua. Lua numbers are doubles, so integers
+ * beyond 2^53 lose precision unless they're pushed as LuaJIT's boxed int64_t
+ * and uint64_t cdata, which scripts can use in arithmetic and comparisons and
+ * which are read back exactly
+ */
+enum class Int64Mode {
+    NUMBER, // always push numbers (default)
+    CDATA_WHEN_INEXACT, // push cdata only for values a number can't represent
+    CDATA // always push cdata
 };
 
-class GluaLua : public GluaBase {
+/**
+ * GluaBase backend for LuaJIT, with JIT control and diagnostics, FFI buffers
+ * and functions, and boxed 64 bit integers
+ */
+class GluaLua : public GluaLuaCommon {
 public:
     /**
    * @brief Constructs a new GluaLua object
    *
-   * @param output_stream stream to which lua 'print' output will be redirected
+   * @param output_stream stream to which lua 'print' output will be redirected,
+   * through an OStreamPrintSink until replaced with SetPrintSink
    * @param start_sandboxed true if the starting environment should be sandboxed
    *                        to protect from dangerous functions like file i/o,
    * etc
@@ -40,19 +48,48 @@ public:
    */
     static auto GetInstanceFromState(lua_State* lua) -> GluaLua&;
 
-    /** GluaBase public interface, implemented by language specific derivations
-   * **/
-
     /**
-   * @copydoc GluaBase::ResetEnvironment(bool)
+   * @brief turns the JIT compiler on or off for the whole state
+   */
+    auto SetJitEnabled(bool enabled) -> void;
+    /**
+   * @brief turns the JIT compiler on or off for one script function
+   *
+   * @param function_name the global name of the function
+   * @param enabled true to allow compiling the function
+   * @param include_subfunctions true to apply to functions defined inside it
+   * too
    */
-    auto ResetEnvironment(bool sandboxed = true) -> void override;
+    auto SetFunctionJitEnabled(const std::string& function_name, bool enabled,
+        bool include_subfunctions = false) -> void;
     /**
-   * @copydoc GluaBase::RegisterCallable(const std::string&, Callable)
+   * @brief discards all compiled traces
    */
-    auto RegisterCallable(const std::string& name, Callable callable)
-        -> void override;
-    /*****************************************************************************/
+    auto FlushJit() -> void;
+    /**
+   * @brief sets JIT optimizer parameters, see `jit.opt.start`
+   */
+    auto SetJitOptions(const JitOptions& options) -> void;
+    /**
+   * @brief starts or stops collecting trace events into the trace report.
+   * Collecting has a cost for every trace event, so it's off by default
+   */
+    auto SetTraceDiagnosticsEnabled(bool enabled) -> void;
+    /**
+   * @return the trace events collected so far
+   */
+    auto GetTraceReport() const -> const JitTraceReport&;
+    /**
+   * @brief discards the trace events collected so far
+   */
+    auto ClearTraceReport() -> void;
+
+    /**
+   * @brief sets how 64 bit integers are pushed. Reading 64 bit integers
+   * accepts both numbers and int64_t/uint64_t cdata regardless of the mode
+   */
+    auto SetInt64Mode(Int64Mode mode) -> void;
+    auto GetInt64Mode() const -> Int64Mode;
 
     /**
    * @brief defaulted destructor override
@@ -62,109 +99,48 @@ public:
 protected:
     /** GluaBase protected interface, implemented by language specific derivations
    * **/
-    auto push(std::nullopt_t /*unused*/) -> void override;
-    auto push(bool value) -> void override;
-    auto push(int8_t value) -> void override;
-    auto push(int16_t value) -> void override;
-    auto push(int32_t value) -> void override;
     auto push(int64_t value) -> void override;
-    auto push(uint8_t value) -> void override;
-    auto push(uint16_t value) -> void override;
-    auto push(uint32_t value) -> void override;
     auto push(uint64_t value) -> void override;
-    auto push(float value) -> void override;
-    auto push(double value) -> void override;
-    auto push(const char* value) -> void override;
-    auto push(std::string_view value) -> void override;
-    auto push(std::string value) -> void override;
-    auto pushArray(size_t size_hint) -> void override;
-    auto pushStartMap(size_t size_hint) -> void override;
-    auto arraySetFromStack() -> void override;
-    auto mapSetFromStack() -> void override;
-    auto pushUserType(const std::string& unique_type_name,
-        std::unique_ptr<IManagedTypeStorage> user_storage)
-        -> void override;
-    auto getBool(int stack_index) const -> bool override;
-    auto getInt8(int stack_index) const -> int8_t override;
-    auto getInt16(int stack_index) const -> int16_t override;
-    auto getInt32(int stack_index) const -> int32_t override;
+    auto defineFfiType(const std::string& type_name, const std::string& cdef,
+        size_t expected_size) -> void override;
+    auto pushFfiBuffer(const std::string& element_type_name, void* data,
+        size_t size, std::shared_ptr<const void> owner) -> void override;
+    auto registerFfiFunctionImpl(const std::string& name,
+        const std::string& signature, void* function) -> void override;
     auto getInt64(int stack_index) const -> int64_t override;
-    auto getUInt8(int stack_index) const -> uint8_t override;
-    auto getUInt16(int stack_index) const -> uint16_t override;
-    auto getUInt32(int stack_index) const -> uint32_t override;
     auto getUInt64(int stack_index) const -> uint64_t override;
-    auto getFloat(int stack_index) const -> float override;
-    auto getDouble(int stack_index) const -> double override;
-    auto getCharPointer(int stack_index) const -> const char* override;
-    auto getStringView(int stack_index) const -> std::string_view override;
-    auto getString(int stack_index) const -> std::string override;
-    auto getArraySize(int stack_index) const -> size_t override;
-    auto getArrayValue(size_t index_into_array, int stack_index_of_array) const
-        -> void override;
-    auto getMapKeys(int stack_index) const -> std::vector<std::string> override;
-    auto getMapValue(const std::string& key, int stack_index_of_map) const
-        -> void override;
-    auto getUserType(const std::string& unique_type_name, int stack_index) const
-        -> IManagedTypeStorage* override;
-    auto isUserType(const std::string& unique_type_name, int stack_index) const
-        -> bool override;
-    auto isNull(int stack_index) const -> bool override;
-    auto isBool(int stack_index) const -> bool override;
-    auto isInt8(int stack_index) const -> bool override;
-    auto isInt16(int stack_index) const -> bool override;
-    auto isInt32(int stack_index) const -> bool override;
+    auto tryGetInteger(int stack_index) const
+        -> std::optional<int64_t> override;
+    auto getFfiBuffer(const std::string& element_type_name, int stack_index) const
+        -> std::optional<std::pair<void*, size_t>> override;
     auto isInt64(int stack_index) const -> bool override;
-    auto isUInt8(int stack_index) const -> bool override;
-    auto isUInt16(int stack_index) const -> bool override;
-    auto isUInt32(int stack_index) const -> bool override;
     auto isUInt64(int stack_index) const -> bool override;
-    auto isFloat(int stack_index) const -> bool override;
-    auto isDouble(int stack_index) const -> bool override;
-    auto isCharPointer(int stack_index) const -> bool override;
-    auto isStringView(int stack_index) const -> bool override;
-    auto isString(int stack_index) const -> bool override;
-    auto isArray(int stack_index) const -> bool override;
-    auto isMap(int stack_index) const -> bool override;
-    auto setGlobalFromStack(const std::string& name, int stack_index)
-        -> void override;
-    auto pushGlobal(const std::string& name) -> void override;
-    auto popOffStack(size_t count) -> void override;
-    auto getStackTop() -> int override;
-    auto callScriptFunctionImpl(const std::string& function_name,
-        size_t arg_count = 0) -> void override;
-    auto
-    registerClassImpl(const std::string& class_name,
-        std::unordered_map<std::string, std::unique_ptr<ICallable>>
-            method_callables) -> void override;
-    auto registerMethodImpl(const std::string& class_name,
-        const std::string& method_name, Callable method)
-        -> void override;
-    auto transformObjectIndex(size_t index) -> size_t override;
-    auto transformFunctionParameterIndex(size_t index) -> size_t override;
-    auto runScript(std::string_view script_data) -> void override;
     /********************************************************************************/
 
 private:
-    auto pushValueOfGlobalOntoStack(const std::string& global_name) -> void;
-    auto setValueOfGlobalFromTopOfStack(const std::string& global_name) -> void;
-    auto absoluteIndex(int index) const -> int;
-
-    std::unique_ptr<lua_State, LuaStateDeleter> m_lua;
-
-    std::unordered_map<std::string, std::unique_ptr<ICallable>> m_registry;
-    std::unordered_map<
-        std::string, std::unordered_map<std::string, std::unique_ptr<ICallable>>>
-        m_method_registry;
-    std::unordered_map<std::type_index, std::string> m_class_to_metatable_name;
-
-    std::reference_wrapper<std::ostream>
-        m_output_stream; // reference wrapper so it's movable
-
-    std::optional<size_t> m_current_array_index;
-    std::optional<std::string> m_current_map_key;
+    // the payload of a boxed int64_t or uint64_t
+    struct BoxedInteger {
+        uint64_t bits;
+        bool is_unsigned;
+
+        auto fitsInt64() const -> bool { return !is_unsigned || bits >> 63u == 0; }
+        auto fitsUInt64() const -> bool { return is_unsigned || bits >> 63u == 0; }
+    };
+
+    auto setEnvironmentOfFunction(int stack_index) -> void override;
+    auto pushFfiBridgeFunction(const char* name) const -> void;
+    auto callFfiBridgeFunction(int arg_count, int result_count) const -> void;
+    auto pushBoxedInteger(uint64_t bits, bool is_unsigned) -> void;
+    auto getBoxedInteger(int stack_index) const -> std::optional<BoxedInteger>;
+
+    mutable std::optional<int> m_ffi_bridge_ref; // loaded on first FFI use
+    mutable void* m_integer_box; // FFI bridge slot for boxing 64 bit integers
+    Int64Mode m_int64_mode;
+    std::optional<int> m_trace_handler_ref; // set while collecting trace events
+    std::unique_ptr<JitTraceReport> m_trace_report; // stable address for lua
 };
 
-auto call_callable_from_lua(lua_State* state) -> int;
-auto destruct_managed_type(lua_State* state) -> int;
+auto destruct_ffi_owner(lua_State* state) -> int;
+auto record_jit_trace_event(lua_State* state) -> int;
 
 } // namespace kdk::glua
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "glua/GluaLuaCommon.h"
+
+namespace kdk::glua {
+/**
+ * GluaBase backend for Lua 5.4. Scripts run with the same sandbox and
+ * registration semantics as GluaLua, with environments set through each
+ * function's _ENV upvalue instead of setfenv. Integers are native 64 bit
+ * integers and the collector runs in generational mode. FFI buffers and FFI
+ * functions require LuaJIT and throw with this backend
+ */
+class GluaLua54 : public GluaLuaCommon {
+public:
+    /**
+   * @brief Constructs a new GluaLua54 object
+   *
+   * @param output_stream stream to which lua 'print' output will be redirected,
+   * through an OStreamPrintSink until replaced with SetPrintSink
+   * @param start_sandboxed true if the starting environment should be sandboxed
+   *                        to protect from dangerous functions like file i/o,
+   * etc
+   */
+    explicit GluaLua54(std::ostream& output_stream, bool start_sandboxed = true);
+
+    GluaLua54(const GluaLua54&) = delete;
+    GluaLua54(GluaLua54&&) noexcept = default;
+
+    auto operator=(const GluaLua54&) -> GluaLua54& = delete;
+    auto operator=(GluaLua54&&) noexcept -> GluaLua54& = default;
+
+    /**
+   * @brief Retrieves a GluaLua54 instance from a lua_State object, if that
+   * lua_State was created and managed by a GluaLua54 instance
+   *
+   * @param lua the lua state to retrieve the instance from
+   * @return a reference to the GluaLua54 instance for the given state
+   */
+    static auto GetInstanceFromState(lua_State* lua) -> GluaLua54&;
+
+    /**
+   * @brief defaulted destructor override
+   */
+    ~GluaLua54() override = default;
+
+protected:
+    /** GluaBase protected interface, implemented by language specific derivations
+   * **/
+    auto push(int64_t value) -> void override;
+    auto push(uint64_t value) -> void override;
+    auto defineFfiType(const std::string& type_name, const std::string& cdef,
+        size_t expected_size) -> void override;
+    auto pushFfiBuffer(const std::string& element_type_name, void* data,
+        size_t size, std::shared_ptr<const void> owner) -> void override;
+    auto registerFfiFunctionImpl(const std::string& name,
+        const std::string& signature, void* function) -> void override;
+    auto getInt64(int stack_index) const -> int64_t override;
+    auto getUInt64(int stack_index) const -> uint64_t override;
+    auto tryGetInteger(int stack_index) const
+        -> std::optional<int64_t> override;
+    auto getFfiBuffer(const std::string& element_type_name, int stack_index) const
+        -> std::optional<std::pair<void*, size_t>> override;
+    auto isInt64(int stack_index) const -> bool override;
+    auto isUInt64(int stack_index) const -> bool override;
+    /********************************************************************************/
+
+private:
+    auto setEnvironmentOfFunction(int stack_index) -> void override;
+};
+
+} // namespace kdk::glua
@@ -0,0 +1,301 @@
+#pragma once
+
+#include "glua/GluaBase.h"
+#include "glua/LuaScriptError.h"
+#include "glua/PrintSink.h"
+#include "glua/ScriptMetrics.h"
+
+#include <unordered_set>
+
+extern "C" {
+#include "lauxlib.h"
+#include "lua.h"
+#include "lualib.h"
+}
+
+namespace kdk::glua {
+struct LuaStateDeleter {
+    auto operator()(lua_State* state) -> void;
+};
+
+/**
+ * The globals and library functions copied into the sandbox environment,
+ * which differ between Lua versions
+ */
+struct SandboxEnvironment {
+    std::vector<std::string> globals;
+    // library name and the names of the functions kept from it
+    std::vector<std::pair<std::string, std::vector<std::string>>> libraries;
+};
+
+/**
+ * The part of the Lua backends written against the C API which LuaJIT and
+ * Lua 5.4 share, see LuaCompat.h for the calls that differ. GluaLua and
+ * GluaLua54 derive from it and implement what depends on the Lua version:
+ * the standard library, setting function environments, 64 bit integers and
+ * FFI
+ */
+class GluaLuaCommon : public GluaBase {
+public:
+    GluaLuaCommon(const GluaLuaCommon&) = delete;
+    GluaLuaCommon(GluaLuaCommon&&) noexcept = default;
+
+    auto operator=(const GluaLuaCommon&) -> GluaLuaCommon& = delete;
+    auto operator=(GluaLuaCommon&&) noexcept -> GluaLuaCommon& = default;
+
+    /**
+   * @brief turns capturing the location and traceback of script errors on or
+   * off. Capturing costs a traceback for every error, so it's off by default
+   * and LuaScriptError only has the error value and function name
+   */
+    auto SetErrorCaptureEnabled(bool enabled) -> void;
+    auto IsErrorCaptureEnabled() const -> bool;
+
+    /**
+   * @brief replaces where lua 'print' output goes. The previous sink is
+   * flushed first, so no printed line is lost
+   */
+    auto SetPrintSink(std::shared_ptr<IPrintSink> sink) -> void;
+    auto GetPrintSink() const -> const std::shared_ptr<IPrintSink>&;
+
+    /**
+   * @brief turns collecting metrics on or off: calls, errors and latencies
+   * per script function called with CallScriptFunction and per registered
+   * callable, and the state's garbage collections and memory. Off by default
+   */
+    auto SetMetricsEnabled(bool enabled) -> void;
+    /**
+   * @return the metrics, which may be snapshot from any thread
+   */
+    auto GetMetrics() const -> const ScriptMetrics&;
+
+    /** GluaBase public interface, implemented by language specific derivations
+   * **/
+
+    /**
+   * @copydoc GluaBase::ResetEnvironment(bool)
+   */
+    auto ResetEnvironment(bool sandboxed = true) -> void override;
+    /**
+   * @copydoc GluaBase::RegisterCallable(const std::string&, Callable)
+   */
+    auto RegisterCallable(const std::string& name, Callable callable)
+        -> void override;
+    /*****************************************************************************/
+
+    /**
+   * @brief defaulted destructor override
+   */
+    ~GluaLuaCommon() override = default;
+
+protected:
+    /**
+   * @brief creates the state with the standard libraries opened
+   *
+   * @param output_stream stream to which lua 'print' output will be redirected,
+   * through an OStreamPrintSink until replaced with SetPrintSink
+   */
+    explicit GluaLuaCommon(std::ostream& output_stream);
+
+    /**
+   * @brief creates the sandbox environment from the given names, overrides
+   * print in it and in _G, and resets the environment
+   */
+    auto setUpSandbox(const SandboxEnvironment& environment,
+        bool start_sandboxed) -> void;
+
+    /** GluaBase protected interface, implemented by language specific derivations
+   * **/
+    auto push(std::nullopt_t /*unused*/) -> void override;
+    auto push(bool value) -> void override;
+    auto push(int8_t value) -> void override;
+    auto push(int16_t value) -> void override;
+    auto push(int32_t value) -> void override;
+    auto push(uint8_t value) -> void override;
+    auto push(uint16_t value) -> void override;
+    auto push(uint32_t value) -> void override;
+    auto push(float value) -> void override;
+    auto push(double value) -> void override;
+    auto push(const char* value) -> void override;
+    auto push(std::string_view value) -> void override;
+    auto push(std::string value) -> void override;
+    auto pushArray(size_t size_hint) -> void override;
+    auto pushStartMap(size_t size_hint) -> void override;
+    auto arraySetFromStack() -> void override;
+    auto mapSetFromStack() -> void override;
+    auto pushUserType(const std::string& unique_type_name,
+        std::unique_ptr<IManagedTypeStorage> user_storage)
+        -> void override;
+    auto pushCachedUserType(const std::string& unique_type_name,
+        const void* address, bool requires_ownership) -> bool override;
+    auto pushContainerProxy(std::unique_ptr<IContainerProxy> proxy)
+        -> void override;
+    auto getBool(int stack_index) const -> bool override;
+    auto getInt8(int stack_index) const -> int8_t override;
+    auto getInt16(int stack_index) const -> int16_t override;
+    auto getInt32(int stack_index) const -> int32_t override;
+    auto getUInt8(int stack_index) const -> uint8_t override;
+    auto getUInt16(int stack_index) const -> uint16_t override;
+    auto getUInt32(int stack_index) const -> uint32_t override;
+    auto getFloat(int stack_index) const -> float override;
+    auto getDouble(int stack_index) const -> double override;
+    auto getCharPointer(int stack_index) const -> const char* override;
+    auto tryGetNumber(int stack_index) const -> std::optional<double> override;
+    auto tryGetStringView(int stack_index) const
+        -> std::optional<std::string_view> override;
+    auto getStringView(int stack_index) const -> std::string_view override;
+    auto getString(int stack_index) const -> std::string override;
+    auto getArraySize(int stack_index) const -> size_t override;
+    auto getArrayValue(size_t index_into_array, int stack_index_of_array) const
+        -> void override;
+    auto getMapKeys(int stack_index) const -> std::vector<std::string> override;
+    auto getMapValue(std::string_view key, int stack_index_of_map) const
+        -> void override;
+    auto nextMapEntry(int stack_index_of_map) const -> bool override;
+    auto pushValueCopy(int stack_index) -> void override;
+    auto internKey(std::string_view key) -> int override;
+    auto pushInternedKey(int key_ref) -> void override;
+    auto getInternedMapValue(int key_ref, int stack_index_of_map) const
+        -> void override;
+    auto walkTablePath(const TablePathSegment* segments, size_t segment_count)
+        -> void override;
+    auto getUserType(const std::string& unique_type_name, int stack_index) const
+        -> IManagedTypeStorage* override;
+    auto isUserType(const std::string& unique_type_name, int stack_index) const
+        -> bool override;
+    auto getContainerProxy(int stack_index) const -> IContainerProxy* override;
+    auto getValueType(int stack_index) const -> GluaValueType override;
+    auto isNull(int stack_index) const -> bool override;
+    auto isBool(int stack_index) const -> bool override;
+    auto isInt8(int stack_index) const -> bool override;
+    auto isInt16(int stack_index) const -> bool override;
+    auto isInt32(int stack_index) const -> bool override;
+    auto isUInt8(int stack_index) const -> bool override;
+    auto isUInt16(int stack_index) const -> bool override;
+    auto isUInt32(int stack_index) const -> bool override;
+    auto isFloat(int stack_index) const -> bool override;
+    auto isDouble(int stack_index) const -> bool override;
+    auto isCharPointer(int stack_index) const -> bool override;
+    auto isStringView(int stack_index) const -> bool override;
+    auto isString(int stack_index) const -> bool override;
+    auto isArray(int stack_index) const -> bool override;
+    auto isMap(int stack_index) const -> bool override;
+    auto setGlobalFromStack(const std::string& name, int stack_index)
+        -> void override;
+    auto pushGlobal(const std::string& name) -> void override;
+    auto popOffStack(size_t count) -> void override;
+    auto removeFromStack(int stack_index) -> void override;
+    auto getStackTop() -> int override;
+    auto setStackTop(int stack_top) -> void override;
+    auto callScriptFunctionImpl(const std::string& function_name,
+        size_t arg_count = 0) -> void override;
+    auto
+    registerClassImpl(const std::string& class_name,
+        std::unordered_map<std::string, std::unique_ptr<ICallable>>
+            method_callables) -> void override;
+    auto registerMethodImpl(const std::string& class_name,
+        const std::string& method_name, Callable method)
+        -> void override;
+    auto setIdentityCacheEnabledImpl(const std::string& class_name,
+        bool enabled) -> void override;
+    auto registerPropertyImpl(const std::string& class_name,
+        const std::string& property_name, Callable getter,
+        std::optional<Callable> setter) -> void override;
+    auto registerBaseClassImpl(const std::string& class_name,
+        const std::string& base_class_name) -> void override;
+    auto registerAncestorClassImpl(const std::string& class_name,
+        const std::string& ancestor_class_name) -> void override;
+    auto transformObjectIndex(size_t index) -> size_t override;
+    auto transformFunctionParameterIndex(size_t index) -> size_t override;
+    auto runScript(std::string_view script_data) -> void override;
+    /********************************************************************************/
+
+    auto pushValueOfGlobalOntoStack(const std::string& global_name) -> void;
+    auto setRegisteredGlobalFromTopOfStack(const std::string& name) -> void;
+
+    std::unique_ptr<lua_State, LuaStateDeleter> m_lua;
+
+    std::unordered_map<std::string, std::unique_ptr<ICallable>> m_registry;
+    // FFI functions have no callable, their names are reserved here instead
+    std::unordered_set<std::string> m_ffi_function_names;
+
+private:
+    /**
+   * @brief makes the function at stack_index see the current environment as
+   * its globals
+   */
+    virtual auto setEnvironmentOfFunction(int stack_index) -> void = 0;
+
+    auto pushCallable(ICallable* callable, std::string metrics_name) -> void;
+    auto pushCallableUpvalue(ICallable* callable) -> bool;
+    auto pushPropertyTables(const std::string& class_name) -> void;
+    auto setIndexFallback(int table_index, int fallback_index) -> void;
+    auto isDerivedUserType(const std::string& unique_type_name,
+        int stack_index) const -> bool;
+    auto protectedCall(const std::string& function_name, int arg_count) -> void;
+    auto observedProtectedCall(const std::string& function_name, int arg_count)
+        -> void;
+    [[noreturn]] auto throwScriptError(const std::string& function_name) -> void;
+    auto getMemoryBytes() const -> uint64_t;
+    auto armGcCycleCounter() -> void;
+
+    std::unordered_map<
+        std::string, std::unordered_map<std::string, std::unique_ptr<ICallable>>>
+        m_method_registry;
+    std::vector<std::unique_ptr<ICallable>> m_property_callables;
+    std::unordered_map<std::string, int> m_identity_cache_refs; // per class, weak valued
+
+    std::unique_ptr<PrintTarget> m_print_target; // stable address for lua
+    std::unique_ptr<ScriptMetrics> m_metrics; // stable address for lua
+
+    bool m_error_capture_enabled;
+    int m_error_handler_ref;
+    std::unique_ptr<ScriptErrorDetails> m_error_details; // stable address for lua
+};
+
+/**
+ * Runs the C++ part of a lua_CFunction, turning any exception into a Lua
+ * error raised once the C++ objects of the call are destroyed. Lua 5.4 is
+ * built as C and raises errors with longjmp, which must not cross live C++
+ * frames, and C++ exceptions must not unwind through its frames either
+ *
+ * @param function called with no arguments, returns the result count
+ * @return the result count, unless a Lua error was raised
+ */
+template <typename Function>
+auto call_protected(lua_State* state, Function&& function) -> int
+{
+    try {
+        return function();
+    } catch (const std::exception& exception) {
+        // prefixed with the calling script's position, as luaL_error does
+        luaL_where(state, 1);
+        lua_pushstring(state, exception.what());
+        lua_concat(state, 2);
+    } catch (...) {
+#if LUA_VERSION_NUM < 502
+        // LuaJIT raises its own errors as foreign exceptions, let them unwind
+        throw;
+#else
+        lua_pushliteral(state, "unknown C++ exception");
+#endif
+    }
+
+    return lua_error(state);
+}
+
+auto call_callable_from_lua(lua_State* state) -> int;
+auto call_thunk_from_lua(lua_State* state) -> int;
+auto destruct_thunk(lua_State* state) -> int;
+auto destruct_managed_type(lua_State* state) -> int;
+auto class_property_index(lua_State* state) -> int;
+auto class_property_newindex(lua_State* state) -> int;
+auto container_proxy_index(lua_State* state) -> int;
+auto container_proxy_newindex(lua_State* state) -> int;
+auto container_proxy_length(lua_State* state) -> int;
+auto container_proxy_next(lua_State* state) -> int;
+auto container_proxy_pairs(lua_State* state) -> int;
+auto destruct_container_proxy(lua_State* state) -> int;
+auto capture_script_error(lua_State* state) -> int;
+
+} // namespace kdk::glua
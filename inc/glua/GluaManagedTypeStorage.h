@@ -1,9 +1,15 @@
 #pragma once
 
+#include "glua/BorrowTable.h"
+
+#include <memory>
+#include <typeindex>
+
 namespace kdk::glua {
 enum class ManagedTypeStorageType { RAW_PTR,
     SHARED_PTR,
-    STACK_ALLOCATED };
+    STACK_ALLOCATED,
+    BORROWED };
 
 class IManagedTypeStorage {
 public:
@@ -18,6 +24,17 @@ public:
 
     virtual auto GetStorageType() const -> ManagedTypeStorageType = 0;
 
+    // the registered type and address of the stored object, used to upcast
+    // instances of derived classes to their registered bases
+    virtual auto GetStoredType() const -> std::type_index = 0;
+    virtual auto GetStoredPointer() -> void* = 0;
+
+    // shares ownership of the stored object, empty unless stored as shared_ptr
+    virtual auto GetSharedOwner() const -> std::shared_ptr<void> { return nullptr; }
+
+    // false once the stored object may no longer be used, e.g. a released borrow
+    virtual auto IsValid() const -> bool { return true; }
+
     virtual ~IManagedTypeStorage() = default;
 };
 
@@ -26,6 +43,15 @@ class ManagedTypeStorage : public IManagedTypeStorage {
 public:
     virtual auto GetStoredValue() const -> const T& = 0;
     virtual auto GetStoredValue() -> T& = 0;
+
+    auto GetStoredType() const -> std::type_index override
+    {
+        return std::type_index { typeid(T) };
+    }
+    auto GetStoredPointer() -> void* override
+    {
+        return std::addressof(GetStoredValue());
+    }
 };
 
 template <typename T>
@@ -54,6 +80,8 @@ public:
     auto GetStoredValue() const -> const T& override { return *m_value; }
     auto GetStoredValue() -> T& override { return *m_value; }
 
+    auto GetSharedOwner() const -> std::shared_ptr<void> override { return m_value; }
+
     ~ManagedTypeSharedPtr() override = default;
 
 private:
@@ -131,4 +159,36 @@ private:
     T m_value;
 };
 
+template <typename T>
+class ManagedTypeBorrowed : public ManagedTypeStorage<T> {
+public:
+    explicit ManagedTypeBorrowed(Borrowed<T> value)
+        : m_value(std::move(value))
+    {
+    }
+    ManagedTypeBorrowed(const ManagedTypeBorrowed&) = default;
+    ManagedTypeBorrowed(ManagedTypeBorrowed&&) noexcept = default;
+
+    auto operator=(const ManagedTypeBorrowed&) -> ManagedTypeBorrowed& = default;
+    auto operator=(ManagedTypeBorrowed&&) noexcept
+        -> ManagedTypeBorrowed& = default;
+
+    auto GetStorageType() const -> ManagedTypeStorageType override
+    {
+        return ManagedTypeStorageType::BORROWED;
+    }
+
+    auto GetValue() const -> const Borrowed<T>& { return m_value; }
+
+    auto GetStoredValue() const -> const T& override { return m_value.Get(); }
+    auto GetStoredValue() -> T& override { return m_value.Get(); }
+
+    auto IsValid() const -> bool override { return m_value.IsValid(); }
+
+    ~ManagedTypeBorrowed() override = default; // the lender owns the object
+
+private:
+    Borrowed<T> m_value;
+};
+
 } // namespace kdk::glua
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "glua/ICallable.h"
+
+#include <array>
+#include <cstddef>
+#include <tuple>
+#include <type_traits>
+
+namespace kdk::glua {
+class GluaBase;
+
+/**
+ * Describes one overload of a GluaOverloadedCallable, generated at compile
+ * time from its signature. Each parameter has a mask of the GluaValueTypes it
+ * accepts (bit `1 << GluaValueType`), trailing parameters accepting nil may be
+ * left out by the caller
+ */
+struct GluaOverloadSignature {
+    size_t min_arity;
+    size_t max_arity;
+    const unsigned* parameter_masks;
+    // false when the value types can't tell the overload apart, e.g. for
+    // registered classes which are all userdata
+    bool is_decided_by_type;
+    // checks the passed arguments with their resolvers, for the overloads not
+    // decided by type and for arguments needing a coercion
+    bool (*is_match)(GluaBase* glua, int first_index, size_t arg_count);
+};
+
+/**
+ * The parameters a functor, function pointer or method pointer is called
+ * with from the glua stack as a std::tuple, methods take their object first
+ */
+template <typename Functor, typename = void>
+struct GluaCallableParameters;
+
+template <typename ReturnType, typename... Params>
+struct GluaCallableParameters<ReturnType (*)(Params...)> {
+    using type = std::tuple<Params...>;
+};
+
+template <typename ClassType, typename ReturnType, typename... Params>
+struct GluaCallableParameters<ReturnType (ClassType::*)(Params...)> {
+    using type = std::tuple<ClassType&, Params...>;
+};
+
+template <typename ClassType, typename ReturnType, typename... Params>
+struct GluaCallableParameters<ReturnType (ClassType::*)(Params...) const> {
+    using type = std::tuple<const ClassType&, Params...>;
+};
+
+template <typename Functor>
+struct GluaCallableParameters<Functor,
+    std::enable_if_t<std::is_class<Functor>::value>> {
+    // the call operator's object is the functor itself, drop it
+    template <typename Tuple>
+    struct WithoutObject;
+
+    template <typename Object, typename... Params>
+    struct WithoutObject<std::tuple<Object, Params...>> {
+        using type = std::tuple<Params...>;
+    };
+
+    using type = typename WithoutObject<
+        typename GluaCallableParameters<decltype(&Functor::operator())>::type>::type;
+};
+
+template <typename Functor>
+constexpr auto glua_overload_signature() -> GluaOverloadSignature;
+
+/**
+ * Several callables registered under one name. Calls go to the first overload
+ * whose argument count and value types match the arguments, then to the first
+ * whose parameters the arguments can be converted to
+ */
+template <size_t OverloadCount, size_t MaxArity>
+class GluaOverloadedCallable : public ICallable {
+public:
+    GluaOverloadedCallable(GluaBase* glua,
+        const GluaOverloadSignature* signatures,
+        std::array<Callable, OverloadCount> overloads);
+    GluaOverloadedCallable(const GluaOverloadedCallable&) = delete;
+    GluaOverloadedCallable(GluaOverloadedCallable&&) noexcept = default;
+
+    auto operator=(const GluaOverloadedCallable&) -> GluaOverloadedCallable& = delete;
+    auto operator=(GluaOverloadedCallable&&) noexcept -> GluaOverloadedCallable& = default;
+
+    auto Call() const -> void override;
+    auto HasReturn() const -> bool override;
+    auto GetImplementationData() const -> void* override;
+
+    ~GluaOverloadedCallable() override = default;
+
+private:
+    GluaBase* m_glua;
+    const GluaOverloadSignature* m_signatures;
+    std::array<Callable, OverloadCount> m_overloads;
+};
+
+} // namespace kdk::glua
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "glua/GluaOverloadedCallable.h"
+
+namespace kdk::glua {
+template <typename ParameterTuple>
+struct GluaOverloadParameters;
+
+template <typename... Params>
+struct GluaOverloadParameters<std::tuple<Params...>> {
+    static constexpr unsigned nil_mask = 1u << static_cast<unsigned>(GluaValueType::NIL);
+    static constexpr unsigned scalar_mask = nil_mask
+        | 1u << static_cast<unsigned>(GluaValueType::BOOLEAN)
+        | 1u << static_cast<unsigned>(GluaValueType::NUMBER)
+        | 1u << static_cast<unsigned>(GluaValueType::STRING);
+
+    // never empty, so it has an address for parameterless overloads
+    static constexpr std::array<unsigned, sizeof...(Params) + 1> masks {
+        GluaValueTypeMask<std::decay_t<Params>>::value..., 0u
+    };
+
+    static constexpr auto minArity() -> size_t
+    {
+        size_t min_arity = 0;
+
+        for (size_t i = 0; i < sizeof...(Params); ++i) {
+            if ((masks[i] & nil_mask) == 0) {
+                min_arity = i + 1;
+            }
+        }
+
+        return min_arity;
+    }
+
+    static constexpr bool is_decided_by_type = (((GluaValueTypeMask<std::decay_t<Params>>::value & ~scalar_mask) == 0) && ...);
+
+    static auto isMatch(GluaBase* glua, int first_index, size_t arg_count) -> bool
+    {
+        return isMatchImpl(glua, first_index, arg_count, std::index_sequence_for<Params...> {});
+    }
+
+    template <size_t... Is>
+    static auto isMatchImpl(GluaBase* glua, int first_index, size_t arg_count,
+        std::index_sequence<Is...> /*unused*/) -> bool
+    {
+        // left out arguments are nil, which their parameters accept
+        return ((Is >= arg_count || glua->Is<Params>(first_index + static_cast<int>(Is))) && ...);
+    }
+};
+
+template <typename Functor>
+constexpr auto glua_overload_signature() -> GluaOverloadSignature
+{
+    using Parameters = typename GluaCallableParameters<Functor>::type;
+    using Overload = GluaOverloadParameters<Parameters>;
+
+    return GluaOverloadSignature { Overload::minArity(),
+        std::tuple_size<Parameters>::value, Overload::masks.data(),
+        Overload::is_decided_by_type, &Overload::isMatch };
+}
+
+template <size_t OverloadCount, size_t MaxArity>
+GluaOverloadedCallable<OverloadCount, MaxArity>::GluaOverloadedCallable(
+    GluaBase* glua, const GluaOverloadSignature* signatures,
+    std::array<Callable, OverloadCount> overloads)
+    : m_glua(glua)
+    , m_signatures(signatures)
+    , m_overloads(std::move(overloads))
+{
+}
+
+template <size_t OverloadCount, size_t MaxArity>
+auto GluaOverloadedCallable<OverloadCount, MaxArity>::Call() const -> void
+{
+    auto first_index = static_cast<int>(m_glua->transformFunctionParameterIndex(0));
+    auto arg_count = static_cast<size_t>(m_glua->getStackTop() - first_index + 1);
+
+    // the value type of every argument any overload takes, left out ones are nil
+    std::array<unsigned, MaxArity + 1> arg_masks {};
+
+    for (size_t i = 0; i < MaxArity; ++i) {
+        auto value_type = i < arg_count
+            ? m_glua->getValueType(first_index + static_cast<int>(i))
+            : GluaValueType::NIL;
+
+        arg_masks[i] = 1u << static_cast<unsigned>(value_type);
+    }
+
+    auto is_arity_match = [arg_count](const GluaOverloadSignature& signature) {
+        return arg_count >= signature.min_arity && arg_count <= signature.max_arity;
+    };
+
+    for (size_t overload = 0; overload < OverloadCount; ++overload) {
+        const auto& signature = m_signatures[overload];
+
+        if (!is_arity_match(signature)) {
+            continue;
+        }
+
+        auto is_type_match = true;
+
+        for (size_t i = 0; i < signature.max_arity && is_type_match; ++i) {
+            is_type_match = (signature.parameter_masks[i] & arg_masks[i]) != 0;
+        }
+
+        if (is_type_match
+            && (signature.is_decided_by_type
+                || signature.is_match(m_glua, first_index, arg_count))) {
+            m_overloads[overload].Call();
+            return;
+        }
+    }
+
+    // no exact match, take the first overload the arguments convert to, e.g. a
+    // number passed for a string
+    for (size_t overload = 0; overload < OverloadCount; ++overload) {
+        const auto& signature = m_signatures[overload];
+
+        if (is_arity_match(signature)
+            && signature.is_match(m_glua, first_index, arg_count)) {
+            m_overloads[overload].Call();
+            return;
+        }
+    }
+
+    throw exceptions::GluaTypeException(
+        "No overload matched the argument count and types");
+}
+
+template <size_t OverloadCount, size_t MaxArity>
+auto GluaOverloadedCallable<OverloadCount, MaxArity>::HasReturn() const -> bool
+{
+    for (const auto& overload : m_overloads) {
+        if (overload.HasReturn()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+template <size_t OverloadCount, size_t MaxArity>
+auto GluaOverloadedCallable<OverloadCount, MaxArity>::GetImplementationData() const
+    -> void*
+{
+    return m_glua;
+}
+
+} // namespace kdk::glua
@@ -130,6 +130,9 @@ public:
 
     ~DeferredArgumentCallable() override = default;
 
+protected:
+    auto GetFunctor() -> Functor& { return m_functor; }
+
 private:
     Functor m_functor;
 };
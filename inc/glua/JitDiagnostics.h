@@ -0,0 +1,102 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace kdk::glua {
+/**
+ * Parameters for the JIT optimizer, see LuaJIT's `jit.opt.start`. Unset
+ * parameters keep their current value
+ */
+struct JitOptions {
+    std::optional<int> optimization_level; // 0-3, like -O3
+    std::optional<int> maxtrace;
+    std::optional<int> maxrecord;
+    std::optional<int> maxirconst;
+    std::optional<int> maxside;
+    std::optional<int> maxsnap;
+    std::optional<int> hotloop;
+    std::optional<int> hotexit;
+    std::optional<int> tryside;
+    std::optional<int> instunroll;
+    std::optional<int> loopunroll;
+    std::optional<int> callunroll;
+    std::optional<int> recunroll;
+    std::optional<int> sizemcode;
+    std::optional<int> maxmcode;
+    std::vector<std::string> flags; // individual optimizations, e.g. "-fold"
+
+    /**
+   * @return the arguments for `jit.opt.start`, e.g. "hotloop=56"
+   */
+    auto ToArguments() const -> std::vector<std::string>;
+};
+
+enum class JitTraceEventType {
+    START,
+    STOP,
+    ABORT,
+    FLUSH,
+    COUNT // number of event types, not an event
+};
+
+struct JitTraceEvent {
+    JitTraceEventType type;
+    int trace_id;
+    int parent_trace_id; // 0 unless this is a side trace
+    std::string source; // chunk name of the traced code
+    int line;
+    std::string abort_reason; // only set for aborted traces
+};
+
+/**
+ * Trace events collected while trace diagnostics are enabled. Aborted traces
+ * mark code that keeps running in the interpreter. Events are counted as they
+ * arrive, and only the most recent ones are kept, so a state whose hot loops
+ * keep aborting doesn't grow the report without bound
+ */
+class JitTraceReport {
+public:
+    static constexpr size_t default_event_capacity = 4096;
+
+    /**
+   * @param event_capacity how many of the most recent events are kept
+   */
+    explicit JitTraceReport(size_t event_capacity = default_event_capacity);
+
+    auto AddEvent(JitTraceEvent event) -> void;
+    auto Clear() -> void;
+
+    /**
+   * @return the most recent events, oldest first
+   */
+    auto GetEvents() const -> std::vector<JitTraceEvent>;
+    /**
+   * @return the number of events of the given type since the last Clear
+   */
+    auto Count(JitTraceEventType type) const -> size_t;
+    /**
+   * @return the number of aborted traces per "source:line" since the last
+   * Clear
+   */
+    auto GetAbortsByLocation() const -> const std::map<std::string, size_t>&;
+    /**
+   * @return the number of aborted traces per abort reason since the last
+   * Clear
+   */
+    auto GetAbortsByReason() const -> const std::map<std::string, size_t>&;
+
+private:
+    std::vector<JitTraceEvent> m_events; // ring, m_next_event is the oldest once full
+    size_t m_next_event;
+    size_t m_event_capacity;
+
+    std::array<size_t, static_cast<size_t>(JitTraceEventType::COUNT)> m_counts;
+    std::map<std::string, size_t> m_aborts_by_location;
+    std::map<std::string, size_t> m_aborts_by_reason;
+};
+} // namespace kdk::glua
@@ -0,0 +1,66 @@
+#pragma once
+
+extern "C" {
+#include "lauxlib.h"
+#include "lua.h"
+}
+
+#include <cstddef>
+
+/**
+ * The few C API calls which differ between LuaJIT (the Lua 5.1 API) and Lua
+ * 5.4, so code shared by both backends is written once against these
+ */
+namespace kdk::glua::lua_compat {
+/**
+ * @return a new full userdata of the given size on top of the stack
+ */
+inline auto new_userdata(lua_State* lua, size_t size) -> void*
+{
+#if LUA_VERSION_NUM >= 504
+    return lua_newuserdatauv(lua, size, 0);
+#else
+    return lua_newuserdata(lua, size);
+#endif
+}
+
+/**
+ * @return the length of the value at stack_index without metamethods
+ */
+inline auto raw_length(lua_State* lua, int stack_index) -> size_t
+{
+#if LUA_VERSION_NUM >= 502
+    return static_cast<size_t>(lua_rawlen(lua, stack_index));
+#else
+    return lua_objlen(lua, stack_index);
+#endif
+}
+
+/**
+ * @return stack_index as an index that doesn't change when values are pushed
+ */
+inline auto absolute_index(lua_State* lua, int stack_index) -> int
+{
+#if LUA_VERSION_NUM >= 502
+    return lua_absindex(lua, stack_index);
+#else
+    if (stack_index > 0 || stack_index <= LUA_REGISTRYINDEX) {
+        return stack_index;
+    }
+
+    return lua_gettop(lua) + stack_index + 1;
+#endif
+}
+
+/**
+ * @brief pushes table[index] for the table at stack_index, without metamethods
+ */
+inline auto raw_get_index(lua_State* lua, int stack_index, size_t index) -> void
+{
+#if LUA_VERSION_NUM >= 503
+    lua_rawgeti(lua, stack_index, static_cast<lua_Integer>(index));
+#else
+    lua_rawgeti(lua, stack_index, static_cast<int>(index));
+#endif
+}
+} // namespace kdk::glua::lua_compat
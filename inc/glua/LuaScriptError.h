@@ -0,0 +1,80 @@
+#pragma once
+
+#include "glua/Exceptions.h"
+
+#include <memory>
+#include <optional>
+#include <string>
+
+extern "C" {
+#include "lua.h"
+}
+
+namespace kdk::glua {
+/**
+ * Where a script error was raised, filled in by the error handler only when
+ * error capture is enabled
+ */
+struct ScriptErrorDetails {
+    std::string chunk;
+    int line = 0;
+    std::optional<std::string> traceback;
+};
+
+/**
+ * Thrown when calling a script or script function fails. The error value is
+ * copied when the error is thrown, so the exception doesn't depend on the
+ * state, and the full message is only formatted when it's first requested, so
+ * scripts that raise errors at high rates don't pay for strings they never
+ * read
+ */
+class LuaScriptError : public exceptions::LuaException {
+public:
+    /**
+   * @param function_name the called function, empty for whole scripts
+   * @param error_message the error value converted to a string
+   * @param details location and traceback, if they were captured
+   */
+    LuaScriptError(std::string function_name, std::string error_message,
+        ScriptErrorDetails details);
+
+    /**
+   * @return the error value at stack_index converted to a string, strings and
+   * numbers as they are and other values described by their type
+   */
+    static auto ErrorValueToString(lua_State* lua, int stack_index) -> std::string;
+
+    /**
+   * @return the full message, formatted on first use
+   */
+    auto what() const noexcept -> const char* override;
+
+    auto GetFunctionName() const -> const std::string&;
+    /**
+   * @return the chunk the error was raised in, empty unless error capture was
+   * enabled
+   */
+    auto GetChunk() const -> const std::string&;
+    /**
+   * @return the line the error was raised on, 0 unless error capture was
+   * enabled
+   */
+    auto GetLine() const -> int;
+    auto GetTraceback() const -> const std::optional<std::string>&;
+    /**
+   * @return the error value converted to a string
+   */
+    auto GetErrorMessage() const -> const std::string&;
+
+private:
+    struct ErrorState {
+        std::string function_name;
+        std::string error_message;
+        ScriptErrorDetails details;
+        std::optional<std::string> message; // formatted lazily by what()
+    };
+
+    // shared so copying the exception doesn't copy the strings
+    std::shared_ptr<ErrorState> m_state;
+};
+} // namespace kdk::glua
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace kdk::glua {
+class GluaBase;
+class StackPosition;
+
+/**
+ * A non-owning view of a table on the glua stack, which reads fields from the
+ * table only when they're accessed instead of converting the whole table up
+ * front. Can be used as a parameter or return type of bound functions.
+ *
+ * Like StackPosition this refers to a stack index, so it's only valid as long
+ * as the table remains on the stack at that index, e.g. for the duration of
+ * the bound function call it was passed to. Unlike StackPosition it never
+ * pops the table itself.
+ */
+class LuaTableView {
+public:
+    class Entry;
+    class Iterator;
+    /**
+   * @brief marks the end of iteration, see Iterator
+   */
+    struct Sentinel {
+    };
+
+    /**
+   * Constructs a view of the (already existing) table at the given index
+   *
+   * @param glua the glua instance the table belongs to
+   * @param stack_index the position of the table on the glua stack
+   */
+    LuaTableView(GluaBase* glua, int stack_index);
+
+    /**
+   * @return the (absolute) stack index of the table
+   */
+    auto GetStackIndex() const -> int;
+
+    /**
+   * @return the number of elements in the array part of the table
+   */
+    auto Length() const -> size_t;
+
+    /**
+   * @param key the key to look up
+   * @return true if the table has a non-null value for the given key
+   */
+    auto Contains(std::string_view key) const -> bool;
+
+    /**
+   * @tparam Type the type to convert the value to
+   * @param key the key of the value
+   * @return the value for the given key converted to `Type`
+   */
+    template <typename Type>
+    auto As(std::string_view key) const -> Type;
+    /**
+   * @tparam Type the type to convert the value to
+   * @param index the index of the value within the array part of the table,
+   * 0 based
+   * @return the value at the given index converted to `Type`
+   */
+    template <typename Type>
+    auto As(size_t index) const -> Type;
+
+    /**
+   * @tparam Type the expected type of the value
+   * @param key the key of the value
+   * @return the value for the given key
+   *
+   * @throws std::runtime_error if the value was not of the requested type
+   */
+    template <typename Type>
+    auto Get(std::string_view key) const -> Type;
+    /**
+   * @tparam Type the expected type of the value
+   * @param index the index of the value within the array part of the table,
+   * 0 based
+   * @return the value at the given index
+   *
+   * @throws std::runtime_error if the value was not of the requested type
+   */
+    template <typename Type>
+    auto Get(size_t index) const -> Type;
+
+    /**
+   * @brief pushes the value for the given key onto the stack, e.g. to view a
+   * nested table with `.As<LuaTableView>()`
+   *
+   * @param key the key of the value
+   * @return the stack position of the value
+   */
+    auto PushChild(std::string_view key) const -> StackPosition;
+    /**
+   * @brief pushes the value at the given index onto the stack
+   *
+   * @param index the index of the value within the array part of the table,
+   * 0 based
+   * @return the stack position of the value
+   */
+    auto PushChild(size_t index) const -> StackPosition;
+
+    /**
+   * @brief iterates over every key/value pair of the table, in no particular
+   * order. The current key and value are kept on top of the stack while
+   * iterating, so anything pushed within the loop must be popped again before
+   * the next iteration
+   *
+   * @{
+   */
+    auto begin() const -> Iterator;
+    auto end() const -> Sentinel;
+    /** @} */
+
+private:
+    GluaBase* m_glua; ///< The glua instance the table belongs to
+    int m_stack_index; ///< The absolute stack index of the table
+};
+
+/**
+ * A key/value pair of a table during iteration, only valid until the iterator
+ * is advanced
+ */
+class LuaTableView::Entry {
+public:
+    Entry(GluaBase* glua, int key_index);
+
+    /**
+   * @tparam Type the type to convert the key to
+   * @return the key converted to `Type`, e.g. std::string or size_t
+   */
+    template <typename Type>
+    auto KeyAs() const -> Type;
+
+    /**
+   * @tparam Type the type to convert the value to
+   * @return the value converted to `Type`
+   */
+    template <typename Type>
+    auto ValueAs() const -> Type;
+
+    /**
+   * @tparam Type the type the value is checked against
+   * @return true if the value is of the given type
+   */
+    template <typename Type>
+    auto ValueIs() const -> bool;
+
+    /**
+   * @return the stack index of the value
+   */
+    auto GetValueIndex() const -> int;
+
+private:
+    GluaBase* m_glua;
+    int m_key_index;
+};
+
+/**
+ * Iterates over a table, holding the current key and value on the stack. Move
+ * only, and pops whatever it still holds when destroyed, so breaking out of a
+ * loop early leaves the stack as it was
+ */
+class LuaTableView::Iterator {
+public:
+    Iterator(GluaBase* glua, int table_index);
+
+    Iterator(const Iterator&) = delete;
+    auto operator=(const Iterator&) -> Iterator& = delete;
+
+    Iterator(Iterator&& rhs) noexcept;
+    auto operator=(Iterator&& rhs) noexcept -> Iterator&;
+
+    auto operator*() const -> const Entry&;
+    auto operator->() const -> const Entry*;
+    auto operator++() -> Iterator&;
+
+    auto operator!=(Sentinel /*unused*/) const -> bool;
+    auto operator==(Sentinel /*unused*/) const -> bool;
+
+    ~Iterator();
+
+private:
+    auto advance() -> void;
+
+    GluaBase* m_glua;
+    int m_table_index;
+    bool m_active;
+    Entry m_entry;
+};
+} // namespace kdk::glua
+
+// .tcc implementation file is included by GluaBase.h instead to avoid circular
+// dependency
@@ -0,0 +1,91 @@
+#include "glua/LuaTableView.h"
+
+namespace kdk::glua {
+template <typename Type>
+auto LuaTableView::As(std::string_view key) const -> Type
+{
+    static_assert(!std::is_same<Type, LuaTableView>::value,
+        "views of nested tables must be kept on the stack, use PushChild");
+
+    m_glua->getMapValue(key, m_stack_index);
+    auto result = m_glua->As<Type>(-1);
+    m_glua->popOffStack(1);
+
+    return result;
+}
+
+template <typename Type>
+auto LuaTableView::As(size_t index) const -> Type
+{
+    static_assert(!std::is_same<Type, LuaTableView>::value,
+        "views of nested tables must be kept on the stack, use PushChild");
+
+    m_glua->getArrayValue(m_glua->transformObjectIndex(index), m_stack_index);
+    auto result = m_glua->As<Type>(-1);
+    m_glua->popOffStack(1);
+
+    return result;
+}
+
+template <typename Type>
+auto LuaTableView::Get(std::string_view key) const -> Type
+{
+    static_assert(!std::is_same<Type, LuaTableView>::value,
+        "views of nested tables must be kept on the stack, use PushChild");
+
+    m_glua->getMapValue(key, m_stack_index);
+
+    if (m_glua->Is<Type>(-1)) {
+        auto result = m_glua->As<Type>(-1);
+        m_glua->popOffStack(1);
+
+        return result;
+    }
+
+    m_glua->popOffStack(1);
+    throw std::runtime_error("LuaTableView::Get with invalid type");
+}
+
+template <typename Type>
+auto LuaTableView::Get(size_t index) const -> Type
+{
+    static_assert(!std::is_same<Type, LuaTableView>::value,
+        "views of nested tables must be kept on the stack, use PushChild");
+
+    m_glua->getArrayValue(m_glua->transformObjectIndex(index), m_stack_index);
+
+    if (m_glua->Is<Type>(-1)) {
+        auto result = m_glua->As<Type>(-1);
+        m_glua->popOffStack(1);
+
+        return result;
+    }
+
+    m_glua->popOffStack(1);
+    throw std::runtime_error("LuaTableView::Get with invalid type");
+}
+
+template <typename Type>
+auto LuaTableView::Entry::KeyAs() const -> Type
+{
+    // converting the key in place (e.g. a number to a string) would break
+    // iteration, so convert a copy
+    m_glua->pushValueCopy(m_key_index);
+    auto result = m_glua->As<Type>(-1);
+    m_glua->popOffStack(1);
+
+    return result;
+}
+
+template <typename Type>
+auto LuaTableView::Entry::ValueAs() const -> Type
+{
+    return m_glua->As<Type>(GetValueIndex());
+}
+
+template <typename Type>
+auto LuaTableView::Entry::ValueIs() const -> bool
+{
+    return m_glua->Is<Type>(GetValueIndex());
+}
+} // namespace kdk::glua
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace kdk::glua {
+/**
+ * Receives the lines scripts print. A state writes to its sink from the thread
+ * running it, one line per print call
+ */
+class IPrintSink {
+public:
+    IPrintSink() = default;
+    IPrintSink(const IPrintSink&) = delete;
+    IPrintSink(IPrintSink&&) noexcept = delete;
+
+    auto operator=(const IPrintSink&) -> IPrintSink& = delete;
+    auto operator=(IPrintSink&&) noexcept -> IPrintSink& = delete;
+
+    /**
+   * @brief writes one printed line, without its newline
+   */
+    virtual auto Write(std::string_view line) -> void = 0;
+    /**
+   * @brief blocks until every line written so far reached its destination
+   */
+    virtual auto Flush() -> void { }
+
+    virtual ~IPrintSink() = default;
+};
+
+/**
+ * Writes every line to a stream as it is printed, without flushing it
+ */
+class OStreamPrintSink : public IPrintSink {
+public:
+    explicit OStreamPrintSink(std::ostream& output_stream);
+
+    auto Write(std::string_view line) -> void override;
+    auto Flush() -> void override;
+
+    ~OStreamPrintSink() override = default;
+
+private:
+    std::reference_wrapper<std::ostream> m_output_stream;
+};
+
+/**
+ * Copies printed lines into a lock free ring buffer which a background thread
+ * writes to a stream in batches, flushing once per batch. Lines that don't fit
+ * in the ring are dropped and counted instead of blocking the script. The ring
+ * has a single producer, so a sink must not be shared by states running on
+ * different threads, and nothing else may write to the stream concurrently
+ * unless the stream synchronizes itself like std::cout
+ */
+class BufferedPrintSink : public IPrintSink {
+public:
+    static constexpr size_t default_capacity = 64 * 1024;
+    static constexpr std::chrono::milliseconds default_flush_interval { 10 };
+
+    /**
+   * @param output_stream the stream the writer thread writes to
+   * @param capacity size of the ring in bytes, rounded up to a power of two
+   * @param flush_interval how long the writer thread sleeps between batches
+   */
+    explicit BufferedPrintSink(std::ostream& output_stream,
+        size_t capacity = default_capacity,
+        std::chrono::milliseconds flush_interval = default_flush_interval);
+
+    auto Write(std::string_view line) -> void override;
+    auto Flush() -> void override;
+
+    auto GetBufferedLineCount() const -> uint64_t;
+    auto GetDroppedLineCount() const -> uint64_t;
+
+    /**
+   * @brief stops the writer thread after it wrote every buffered line
+   */
+    ~BufferedPrintSink() override;
+
+private:
+    auto runWriter() -> void;
+    auto drain() -> void;
+
+    std::reference_wrapper<std::ostream> m_output_stream;
+    std::unique_ptr<char[]> m_ring;
+    size_t m_capacity;
+    std::chrono::milliseconds m_flush_interval;
+
+    // running byte offsets, the ring position is the offset modulo capacity
+    std::atomic<uint64_t> m_head; // written by the producer
+    std::atomic<uint64_t> m_tail; // written by the writer thread
+
+    std::atomic<uint64_t> m_buffered_lines;
+    std::atomic<uint64_t> m_dropped_lines;
+
+    // writing never takes the lock, only flushing and the writer thread do
+    std::mutex m_writer_mutex;
+    std::condition_variable m_writer_wake;
+    std::condition_variable m_drained; // signalled after every batch
+    bool m_is_flush_requested;
+    bool m_is_stopping;
+    std::thread m_writer; // started last, once the ring exists
+};
+
+/**
+ * What a state's print writes to, at a stable address for the print closure
+ */
+struct PrintTarget {
+    std::shared_ptr<IPrintSink> sink;
+    std::string line; // reused so printing doesn't allocate per line
+};
+
+} // namespace kdk::glua
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace kdk::glua {
+/**
+ * Latency histogram in the style of HdrHistogram: power of two buckets split
+ * into linear sub buckets, so every value is kept within 12.5% of itself in
+ * constant memory. Values are nanoseconds, longer than max_value_bits allow
+ * are clamped
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned sub_bucket_bits = 3;
+    static constexpr unsigned max_value_bits = 36; // ~68 seconds
+    static constexpr size_t bucket_count
+        = (max_value_bits - sub_bucket_bits + 1) << sub_bucket_bits;
+
+    auto Record(uint64_t value) -> void;
+    auto GetBucketCount(size_t bucket) const -> uint64_t;
+
+    static auto BucketOf(uint64_t value) -> size_t;
+    /**
+   * @return the largest value recorded into `bucket`
+   */
+    static auto BucketUpperBound(size_t bucket) -> uint64_t;
+
+private:
+    std::array<std::atomic<uint64_t>, bucket_count> m_counts {};
+};
+
+struct CallMetricsSnapshot {
+    std::string name;
+    uint64_t call_count;
+    uint64_t error_count;
+    uint64_t total_ns;
+    std::vector<uint64_t> latency_buckets; // see LatencyHistogram
+
+    /**
+   * @return the latency in nanoseconds `quantile` (0 to 1) of calls took at
+   * most, 0 without calls
+   */
+    auto LatencyAtQuantile(double quantile) const -> uint64_t;
+};
+
+struct MetricsSnapshot {
+    std::vector<CallMetricsSnapshot> script_functions;
+    std::vector<CallMetricsSnapshot> callables;
+    uint64_t gc_cycle_count;
+    uint64_t memory_bytes;
+
+    /**
+   * @return the snapshot in the Prometheus text exposition format, latencies
+   * as summaries in seconds
+   *
+   * @param prefix prepended to every metric name
+   */
+    auto ToPrometheusText(std::string_view prefix = "glua") const -> std::string;
+};
+
+/**
+ * Call and error counts and latencies of one script function or callable. A
+ * state runs on one thread at a time, so counters have a single writer and
+ * are updated without atomic read-modify-writes, while snapshots read them
+ * from any thread
+ */
+class CallStats {
+public:
+    explicit CallStats(std::string name);
+
+    auto Record(uint64_t duration_ns, bool is_error) -> void;
+    auto Snapshot() const -> CallMetricsSnapshot;
+
+    /**
+   * @brief calls `call` and records its duration, as an error if it throws
+   */
+    template <typename Call>
+    auto Measure(Call&& call) -> decltype(call());
+
+    static auto Now() -> uint64_t;
+
+private:
+    std::string m_name;
+    std::atomic<uint64_t> m_call_count;
+    std::atomic<uint64_t> m_error_count;
+    std::atomic<uint64_t> m_total_ns;
+    LatencyHistogram m_latency;
+};
+
+class ScriptMetrics;
+
+/**
+ * Where a registered callable's calls are counted, created when registering
+ * so calls need no lookup. Its stats are allocated by the first call made
+ * while metrics are enabled
+ */
+class CallableMetricsSlot {
+public:
+    CallableMetricsSlot(ScriptMetrics& metrics, std::string name);
+
+    auto GetName() const -> const std::string& { return m_name; }
+    auto IsEnabled() const -> bool;
+    auto GetStats() -> CallStats&;
+
+private:
+    ScriptMetrics* m_metrics;
+    std::string m_name;
+    CallStats* m_stats;
+};
+
+/**
+ * The metrics of one state, see GluaLua::SetMetricsEnabled. Snapshots may be
+ * taken from any thread while the state runs
+ */
+class ScriptMetrics {
+public:
+    ScriptMetrics();
+    ScriptMetrics(const ScriptMetrics&) = delete;
+    ScriptMetrics(ScriptMetrics&&) noexcept = delete;
+
+    auto operator=(const ScriptMetrics&) -> ScriptMetrics& = delete;
+    auto operator=(ScriptMetrics&&) noexcept -> ScriptMetrics& = delete;
+
+    auto SetEnabled(bool enabled) -> void;
+    auto IsEnabled() const -> bool
+    {
+        return m_is_enabled.load(std::memory_order_relaxed);
+    }
+
+    auto GetScriptFunctionStats(const std::string& function_name) -> CallStats&;
+    auto AddCallable(std::string name) -> CallableMetricsSlot*;
+    auto AddCallableStats(const std::string& name) -> CallStats&;
+
+    /**
+   * @brief sets the collection counter the state's finalizer increments, it
+   * lives as long as the state
+   */
+    auto SetGcCycleCounter(const std::atomic<uint64_t>* gc_cycle_count) -> void;
+    auto SetMemoryBytes(uint64_t memory_bytes) -> void;
+
+    auto Snapshot() const -> MetricsSnapshot;
+
+    ~ScriptMetrics() = default;
+
+private:
+    std::atomic<bool> m_is_enabled;
+
+    // only the state's thread adds stats and looks them up, snapshots read
+    // them, so adding and snapshotting lock while lookups don't
+    mutable std::mutex m_stats_mutex;
+    std::unordered_map<std::string, std::unique_ptr<CallStats>> m_script_functions;
+    std::vector<std::unique_ptr<CallStats>> m_callables;
+
+    std::vector<std::unique_ptr<CallableMetricsSlot>> m_callable_slots;
+
+    std::atomic<const std::atomic<uint64_t>*> m_gc_cycle_count;
+    std::atomic<uint64_t> m_memory_bytes;
+};
+
+template <typename Call>
+auto CallStats::Measure(Call&& call) -> decltype(call())
+{
+    auto start_ns = Now();
+
+    try {
+        if constexpr (std::is_void<decltype(call())>::value) {
+            call();
+            Record(Now() - start_ns, false);
+        } else {
+            auto result = call();
+            Record(Now() - start_ns, false);
+
+            return result;
+        }
+    } catch (...) {
+        // includes LuaJIT's errors, which unwind like exceptions
+        Record(Now() - start_ns, true);
+        throw;
+    }
+}
+
+} // namespace kdk::glua
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * Records spans of script functions and bound C++ callables into per thread
+ * ring buffers and exports them in the Chrome trace event format, which
+ * chrome://tracing and Perfetto open. Tracing is process wide and off by
+ * default, while off every hook costs one branch on is_enabled()
+ */
+namespace kdk::glua::script_tracer {
+namespace detail {
+    extern std::atomic<bool> is_enabled;
+
+    auto now() -> uint64_t;
+    auto record_span(std::string_view name, uint64_t start_ns, uint64_t end_ns)
+        -> void;
+} // namespace detail
+
+constexpr size_t default_events_per_thread = 64 * 1024;
+
+/**
+ * @brief starts recording, discarding every span recorded before
+ *
+ * @param events_per_thread size of each thread's ring, once full the oldest
+ * spans are overwritten
+ */
+auto start(size_t events_per_thread = default_events_per_thread) -> void;
+auto stop() -> void;
+
+inline auto is_enabled() -> bool
+{
+    return detail::is_enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief opens a span on the calling thread, closed by the next end_span. This
+ * is what the Lua functions added by GluaBase::RegisterTraceFunctions call
+ */
+auto begin_span(std::string_view name) -> void;
+auto end_span() -> void;
+
+/**
+ * @return the number of spans open on the calling thread
+ */
+auto open_span_depth() -> size_t;
+/**
+ * @brief ends the spans opened on the calling thread since it had depth open
+ * spans, for spans whose end_span a script error skipped
+ */
+auto end_spans_above(size_t depth) -> void;
+
+/**
+ * @return every recorded span as Chrome trace event JSON
+ */
+auto export_chrome_trace() -> std::string;
+auto write_chrome_trace(std::string_view filename) -> void;
+
+/**
+ * Records the span of its own lifetime. Construct it only when is_enabled()
+ * so the disabled path stays a single branch
+ */
+class Span {
+public:
+    explicit Span(std::string_view name)
+        : m_name(name)
+        , m_start_ns(detail::now())
+    {
+    }
+    Span(const Span&) = delete;
+    Span(Span&&) noexcept = delete;
+
+    auto operator=(const Span&) -> Span& = delete;
+    auto operator=(Span&&) noexcept -> Span& = delete;
+
+    ~Span() { detail::record_span(m_name, m_start_ns, detail::now()); }
+
+private:
+    std::string_view m_name;
+    uint64_t m_start_ns;
+};
+
+} // namespace kdk::glua::script_tracer
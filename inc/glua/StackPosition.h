@@ -132,6 +132,25 @@ public:
     template <typename Type>
     auto Get() const -> Type;
 
+    /**
+   * @brief converts the item this position refers to into an existing
+   * object, reusing its capacity, see GluaBase::AsInto
+   *
+   * @param out the object to convert the value into
+   */
+    template <typename Type>
+    auto AsInto(Type& out) const -> void;
+
+    /**
+   * @brief like AsInto, but checks the type of the item first
+   *
+   * @param out the object to convert the value into
+   *
+   * @throws std::runtime_error if the item was not of the requested type
+   */
+    template <typename Type>
+    auto GetInto(Type& out) const -> void;
+
     /**
    * @return true if the value at this position is an array
    */
@@ -147,6 +166,20 @@ public:
    */
     auto GetArrayLength() const -> size_t;
 
+    /**
+   * @brief converts the elements of the array at this position into
+   * caller-provided storage, without allocating
+   *
+   * @param buffer the storage to write the converted elements to
+   * @param capacity the number of elements `buffer` can hold
+   * @return the number of elements written to `buffer`
+   *
+   * @throws exceptions::GluaTypeException if the array has more than
+   * `capacity` elements
+   */
+    template <typename Type>
+    auto ReadArray(Type* buffer, size_t capacity) const -> size_t;
+
     /**
    * @brief Destructor which pops the item off the top of the stack
    */
@@ -18,4 +18,22 @@ auto StackPosition::Get() const -> Type
 {
     return m_glua->Get<Type>(m_position.value());
 }
+
+template <typename Type>
+auto StackPosition::AsInto(Type& out) const -> void
+{
+    m_glua->AsInto(m_position.value(), out);
+}
+
+template <typename Type>
+auto StackPosition::GetInto(Type& out) const -> void
+{
+    m_glua->GetInto(m_position.value(), out);
+}
+
+template <typename Type>
+auto StackPosition::ReadArray(Type* buffer, size_t capacity) const -> size_t
+{
+    return m_glua->ReadArray<Type>(m_position.value(), buffer, capacity);
+}
 } // namespace kdk::glua
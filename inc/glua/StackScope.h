@@ -0,0 +1,105 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace kdk::glua {
+class GluaBase;
+
+/**
+ * An RAII frame on the glua stack. It records the stack top when constructed
+ * and restores it with a single operation when destroyed, so any number of
+ * values pushed while it lives are dropped together, including when an
+ * exception unwinds through it.
+ *
+ * Children pushed through the scope are plain stack indices rather than
+ * StackPositions, which makes walking nested tables cheap and keeps loops from
+ * leaking stack slots. StackPositions created after the scope must be
+ * destroyed (or released) before it, since they'd otherwise pop values below
+ * the restored top.
+ */
+class StackScope {
+public:
+    /**
+   * Constructs a scope restoring the current top of the glua stack on exit
+   *
+   * @param glua the glua instance whose stack this scope restores
+   */
+    explicit StackScope(GluaBase* glua);
+
+    StackScope(const StackScope&) = delete;
+    StackScope(StackScope&&) noexcept = delete;
+
+    auto operator=(const StackScope&) -> StackScope& = delete;
+    auto operator=(StackScope&&) noexcept -> StackScope& = delete;
+
+    /**
+   * @return the stack top this scope restores
+   */
+    auto GetTop() const -> int;
+
+    /**
+   * Pushes the child of the object at `parent_index` with the given index,
+   * or a null value if there is no such child. The child stays on the stack
+   * until the scope is restored
+   *
+   * @param parent_index the stack index of the parent object
+   * @param child_index the index of the child, 0 based
+   * @return the (absolute) stack index of the child
+   */
+    auto PushChild(int parent_index, size_t child_index) -> int;
+    /**
+   * Pushes the child of the object at `parent_index` with the given key, or
+   * a null value if there is no such child. The child stays on the stack
+   * until the scope is restored
+   *
+   * @param parent_index the stack index of the parent object
+   * @param child_key the key of the child
+   * @return the (absolute) stack index of the child
+   */
+    auto PushChild(int parent_index, std::string_view child_key) -> int;
+
+    /**
+   * Like PushChild, but throws if there is no such child
+   *
+   * @throws std::out_of_range if no child with the given index exists
+   */
+    auto SafePushChild(int parent_index, size_t child_index) -> int;
+    /**
+   * Like PushChild, but throws if there is no such child
+   *
+   * @throws std::out_of_range if no child with the given key exists
+   */
+    auto SafePushChild(int parent_index, std::string_view child_key) -> int;
+
+    /**
+   * @tparam Type the type to convert the child to
+   * @return the child of the object at `parent_index` with the given index
+   * converted to `Type`, which is not left on the stack
+   */
+    template <typename Type>
+    auto GetChild(int parent_index, size_t child_index) -> Type;
+    /**
+   * @tparam Type the type to convert the child to
+   * @return the child of the object at `parent_index` with the given key
+   * converted to `Type`, which is not left on the stack
+   */
+    template <typename Type>
+    auto GetChild(int parent_index, std::string_view child_key) -> Type;
+
+    /**
+   * @brief drops everything pushed since the scope was constructed, e.g. at
+   * the end of each iteration of a loop, while keeping the scope usable
+   */
+    auto Restore() -> void;
+
+    /**
+   * @brief Destructor which restores the stack top recorded on construction
+   */
+    ~StackScope();
+
+private:
+    GluaBase* m_glua; ///< The glua instance this scope belongs to
+    int m_top; ///< The stack top restored on exit
+};
+} // namespace kdk::glua
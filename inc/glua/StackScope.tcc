@@ -0,0 +1,26 @@
+// .tcc implementation file is included by GluaBase.h instead to avoid circular
+// dependency
+#include "glua/StackScope.h"
+
+namespace kdk::glua {
+template <typename Type>
+auto StackScope::GetChild(int parent_index, size_t child_index) -> Type
+{
+    PushChild(parent_index, child_index);
+    auto result = m_glua->As<Type>(-1);
+    m_glua->popOffStack(1);
+
+    return result;
+}
+
+template <typename Type>
+auto StackScope::GetChild(int parent_index, std::string_view child_key)
+    -> Type
+{
+    PushChild(parent_index, child_key);
+    auto result = m_glua->As<Type>(-1);
+    m_glua->popOffStack(1);
+
+    return result;
+}
+} // namespace kdk::glua
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace kdk::glua {
+class GluaBase;
+class StackPosition;
+
+/**
+ * One step of a TablePath, either an interned key or an array index
+ */
+struct TablePathSegment {
+    int key_ref; ///< the interned key, see GluaBase::internKey
+    size_t index; ///< the backend's array index, already transformed
+    bool is_index; ///< true if this step is `index` rather than `key_ref`
+};
+
+/**
+ * A path into nested tables such as `limits.tenants[42].rate`, compiled once
+ * so evaluating it needs no allocations and walks every table with raw gets
+ * in a single backend call. Keys are separated by `.` and array indices are
+ * written in brackets, 0 based like StackPosition::PushChild.
+ *
+ * Walking stops at the first value that isn't a table, which makes the value
+ * at the end of the path null, just like a missing child. Metatables (e.g.
+ * __index) and container proxies are not consulted.
+ *
+ * The interned keys belong to the glua instance the path was compiled for, so
+ * a path must only be evaluated with that instance.
+ */
+class TablePath {
+public:
+    /**
+   * Compiles the given path
+   *
+   * @param glua the glua instance the path is evaluated with
+   * @param path the keys and indices to walk, e.g. `limits.tenants[42].rate`
+   *
+   * @throws exceptions::GluaBaseException if the path is malformed
+   */
+    TablePath(GluaBase* glua, std::string_view path);
+
+    /**
+   * @return the path this was compiled from
+   */
+    auto GetPath() const -> const std::string&;
+
+    /**
+   * @tparam Type the type to convert the value to
+   * @param stack_index the stack index of the table the path starts at
+   * @return the value at the end of the path converted to `Type`
+   */
+    template <typename Type>
+    auto As(int stack_index) const -> Type;
+    /**
+   * @tparam Type the expected type of the value
+   * @param stack_index the stack index of the table the path starts at
+   * @return the value at the end of the path
+   *
+   * @throws std::runtime_error if the value was not of the requested type
+   */
+    template <typename Type>
+    auto Get(int stack_index) const -> Type;
+    /**
+   * @param stack_index the stack index of the table the path starts at
+   * @return the stack position of the value at the end of the path
+   */
+    auto Push(int stack_index) const -> StackPosition;
+
+    /**
+   * @tparam Type the type to convert the value to
+   * @return the value at the end of the path converted to `Type`, where the
+   * first key of the path is the name of a global
+   *
+   * @throws exceptions::GluaBaseException if the path starts with an index
+   */
+    template <typename Type>
+    auto AsGlobal() const -> Type;
+    /**
+   * @tparam Type the expected type of the value
+   * @return the value at the end of the path, where the first key of the path
+   * is the name of a global
+   *
+   * @throws exceptions::GluaBaseException if the path starts with an index
+   * @throws std::runtime_error if the value was not of the requested type
+   */
+    template <typename Type>
+    auto GetGlobal() const -> Type;
+    /**
+   * @return the stack position of the value at the end of the path, where the
+   * first key of the path is the name of a global
+   *
+   * @throws exceptions::GluaBaseException if the path starts with an index
+   */
+    auto PushGlobal() const -> StackPosition;
+
+private:
+    auto pushValue(int stack_index) const -> void;
+    auto pushGlobalValue() const -> void;
+
+    GluaBase* m_glua; ///< The glua instance the keys are interned in
+    std::string m_path; ///< The path this was compiled from
+    std::vector<TablePathSegment> m_segments; ///< The steps of the path
+    std::string m_global_name; ///< The first key, looked up as a global
+};
+} // namespace kdk::glua
@@ -0,0 +1,50 @@
+// .tcc implementation file is included by GluaBase.h instead to avoid circular
+// dependency
+#include "glua/TablePath.h"
+
+namespace kdk::glua {
+template <typename Type>
+auto TablePath::As(int stack_index) const -> Type
+{
+    StackScope scope { m_glua };
+    pushValue(stack_index);
+
+    return m_glua->As<Type>(-1);
+}
+
+template <typename Type>
+auto TablePath::Get(int stack_index) const -> Type
+{
+    StackScope scope { m_glua };
+    pushValue(stack_index);
+
+    if (!m_glua->Is<Type>(-1)) {
+        throw std::runtime_error("TablePath::Get with invalid type at " + m_path);
+    }
+
+    return m_glua->As<Type>(-1);
+}
+
+template <typename Type>
+auto TablePath::AsGlobal() const -> Type
+{
+    StackScope scope { m_glua };
+    pushGlobalValue();
+
+    return m_glua->As<Type>(-1);
+}
+
+template <typename Type>
+auto TablePath::GetGlobal() const -> Type
+{
+    StackScope scope { m_glua };
+    pushGlobalValue();
+
+    if (!m_glua->Is<Type>(-1)) {
+        throw std::runtime_error(
+            "TablePath::GetGlobal with invalid type at " + m_path);
+    }
+
+    return m_glua->As<Type>(-1);
+}
+} // namespace kdk::glua
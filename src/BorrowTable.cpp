@@ -0,0 +1,57 @@
+#include "glua/BorrowTable.h"
+
+namespace kdk::glua {
+auto BorrowSlots::Acquire() -> std::pair<uint32_t, uint32_t>
+{
+    uint32_t slot = 0;
+
+    if (!m_free_slots.empty()) {
+        slot = m_free_slots.back();
+        m_free_slots.pop_back();
+    } else {
+        if (m_used_count == m_generations.size()) {
+            m_generations.push_back(0);
+        }
+
+        slot = static_cast<uint32_t>(m_used_count++);
+    }
+
+    return { slot, m_generations[slot] };
+}
+
+auto BorrowSlots::Release(uint32_t slot, uint32_t generation) -> void
+{
+    if (m_generations[slot] == generation) {
+        ++m_generations[slot];
+        m_free_slots.push_back(slot);
+    }
+}
+
+auto BorrowSlots::ReleaseAll() -> void
+{
+    // the new epoch makes every outstanding borrow stale, so the slots can be
+    // handed out again without touching their generations
+    ++m_epoch;
+    m_used_count = 0;
+    m_free_slots.clear();
+}
+
+BorrowTable::BorrowTable()
+    : m_slots(std::make_shared<BorrowSlots>())
+{
+}
+
+auto BorrowTable::ReleaseAll() -> void
+{
+    m_slots->ReleaseAll();
+}
+
+BorrowTable::~BorrowTable()
+{
+    // moved from tables have no slots
+    if (m_slots) {
+        m_slots->ReleaseAll();
+    }
+}
+
+} // namespace kdk::glua
@@ -1,6 +1,7 @@
 #include "glua/GluaBase.h"
 
 #include "glua/FileUtil.h"
+#include "glua/ScriptTracer.h"
 
 namespace kdk::glua {
 auto GluaBase::PushChild(int parent_index, size_t child_index)
@@ -56,6 +57,101 @@ auto GluaBase::GetArrayLength(int stack_index) -> size_t
     return getArraySize(stack_index);
 }
 
+auto GluaBase::absoluteStackIndex(int stack_index) -> int
+{
+    if (stack_index > 0) {
+        return stack_index;
+    }
+
+    return getStackTop() + stack_index + 1;
+}
+
+auto GluaBase::internPathKey(std::string_view key) -> int
+{
+    auto key_pos = m_interned_path_keys.find(std::string { key });
+
+    if (key_pos != m_interned_path_keys.end()) {
+        return key_pos->second;
+    }
+
+    auto key_ref = internKey(key);
+    m_interned_path_keys.emplace(std::string { key }, key_ref);
+
+    return key_ref;
+}
+
+auto GluaBase::upcastUserType(IManagedTypeStorage* storage,
+    std::type_index target) -> void*
+{
+    auto class_pos = m_class_upcasts.find(storage->GetStoredType());
+
+    if (class_pos != m_class_upcasts.end()) {
+        auto upcast_pos = class_pos->second.find(target);
+
+        if (upcast_pos != class_pos->second.end()) {
+            return upcast_pos->second(storage->GetStoredPointer());
+        }
+    }
+
+    throw exceptions::GluaBaseException(
+        "Registered type is not derived from the requested type");
+}
+
+auto GluaBase::addUpcast(std::type_index derived, std::type_index base,
+    std::function<void*(void*)> upcast) -> void
+{
+    // the derived class inherits the base and all of the base's ancestors
+    std::unordered_map<std::type_index, std::function<void*(void*)>> added;
+    added.emplace(base, upcast);
+
+    auto base_pos = m_class_upcasts.find(base);
+
+    if (base_pos != m_class_upcasts.end()) {
+        for (const auto& [ancestor, ancestor_upcast] : base_pos->second) {
+            added.emplace(ancestor, [upcast, ancestor_upcast](void* value) {
+                return ancestor_upcast(upcast(value));
+            });
+        }
+    }
+
+    // as do classes already registered as deriving from the derived class
+    std::vector<std::pair<std::type_index, std::function<void*(void*)>>> descendants;
+    descendants.emplace_back(derived, nullptr);
+
+    for (const auto& [descendant, upcasts] : m_class_upcasts) {
+        auto derived_pos = upcasts.find(derived);
+
+        if (derived_pos != upcasts.end()) {
+            descendants.emplace_back(descendant, derived_pos->second);
+        }
+    }
+
+    for (const auto& [descendant, descendant_upcast] : descendants) {
+        auto& upcasts = m_class_upcasts[descendant];
+
+        for (const auto& [ancestor, ancestor_upcast] : added) {
+            if (descendant == derived) {
+                upcasts[ancestor] = ancestor_upcast;
+            } else {
+                upcasts[ancestor] = [descendant_upcast, ancestor_upcast](void* value) {
+                    return ancestor_upcast(descendant_upcast(value));
+                };
+            }
+
+            registerAncestorClassImpl(m_class_to_metatable_name.at(descendant),
+                m_class_to_metatable_name.at(ancestor));
+        }
+    }
+}
+
+auto GluaBase::RegisterTraceFunctions() -> void
+{
+    RegisterCallable("trace_span_begin",
+        CreateGluaCallable(static_cast<void (*)(std::string_view)>(&script_tracer::begin_span)));
+    RegisterCallable("trace_span_end",
+        CreateGluaCallable(static_cast<void (*)()>(&script_tracer::end_span)));
+}
+
 auto GluaBase::PushGlobal(const std::string& name) -> StackPosition
 {
     pushGlobal(name);
@@ -1,6 +1,40 @@
 #include "glua/GluaBase.h"
 
+#include <cmath>
+#include <limits>
+
 namespace kdk::glua {
+auto visited_map_entries() -> std::vector<const void*>&
+{
+    thread_local std::vector<const void*> visited;
+
+    return visited;
+}
+
+/**
+ * @return the number as Integer, or nullopt if it isn't a number, has a
+ * fractional part or is out of Integer's range
+ */
+template <typename Integer>
+static auto checked_integer_from_number(std::optional<double> number)
+    -> std::optional<Integer>
+{
+    if (!number.has_value()) {
+        return std::nullopt;
+    }
+
+    auto value = number.value();
+
+    // NaN fails the first comparison too
+    if (value != std::trunc(value)
+        || value < static_cast<double>(std::numeric_limits<Integer>::min())
+        || value >= std::ldexp(1.0, std::numeric_limits<Integer>::digits)) {
+        return std::nullopt;
+    }
+
+    return static_cast<Integer>(value);
+}
+
 auto GluaResolver<bool>::as(GluaBase* glua, int stack_index) -> bool
 {
     return glua->getBool(stack_index);
@@ -26,6 +60,11 @@ auto GluaResolver<int8_t>::push(GluaBase* glua, int8_t value) -> void
 {
     glua->push(value);
 }
+auto GluaResolver<int8_t>::tryAs(GluaBase* glua, int stack_index)
+    -> std::optional<int8_t>
+{
+    return checked_integer_from_number<int8_t>(glua->tryGetNumber(stack_index));
+}
 
 auto GluaResolver<int16_t>::as(GluaBase* glua, int stack_index) -> int16_t
 {
@@ -39,6 +78,11 @@ auto GluaResolver<int16_t>::push(GluaBase* glua, int16_t value) -> void
 {
     glua->push(value);
 }
+auto GluaResolver<int16_t>::tryAs(GluaBase* glua, int stack_index)
+    -> std::optional<int16_t>
+{
+    return checked_integer_from_number<int16_t>(glua->tryGetNumber(stack_index));
+}
 
 auto GluaResolver<int32_t>::as(GluaBase* glua, int stack_index) -> int32_t
 {
@@ -52,6 +96,11 @@ auto GluaResolver<int32_t>::push(GluaBase* glua, int32_t value) -> void
 {
     glua->push(value);
 }
+auto GluaResolver<int32_t>::tryAs(GluaBase* glua, int stack_index)
+    -> std::optional<int32_t>
+{
+    return checked_integer_from_number<int32_t>(glua->tryGetNumber(stack_index));
+}
 
 auto GluaResolver<int64_t>::as(GluaBase* glua, int stack_index) -> int64_t
 {
@@ -65,6 +114,29 @@ auto GluaResolver<int64_t>::push(GluaBase* glua, int64_t value) -> void
 {
     glua->push(value);
 }
+auto GluaResolver<int64_t>::tryAs(GluaBase* glua, int stack_index)
+    -> std::optional<int64_t>
+{
+    // native integers are exact, converting them to numbers is not
+    auto integer = glua->tryGetInteger(stack_index);
+
+    if (integer.has_value()) {
+        return integer;
+    }
+
+    auto number = glua->tryGetNumber(stack_index);
+
+    if (number.has_value()) {
+        return checked_integer_from_number<int64_t>(number);
+    }
+
+    // backends may box 64 bit integers that numbers can't represent
+    if (glua->isInt64(stack_index)) {
+        return glua->getInt64(stack_index);
+    }
+
+    return std::nullopt;
+}
 
 auto GluaResolver<uint8_t>::as(GluaBase* glua, int stack_index) -> uint8_t
 {
@@ -78,6 +150,11 @@ auto GluaResolver<uint8_t>::push(GluaBase* glua, uint8_t value) -> void
 {
     glua->push(value);
 }
+auto GluaResolver<uint8_t>::tryAs(GluaBase* glua, int stack_index)
+    -> std::optional<uint8_t>
+{
+    return checked_integer_from_number<uint8_t>(glua->tryGetNumber(stack_index));
+}
 
 auto GluaResolver<uint16_t>::as(GluaBase* glua, int stack_index) -> uint16_t
 {
@@ -91,6 +168,11 @@ auto GluaResolver<uint16_t>::push(GluaBase* glua, uint16_t value) -> void
 {
     glua->push(value);
 }
+auto GluaResolver<uint16_t>::tryAs(GluaBase* glua, int stack_index)
+    -> std::optional<uint16_t>
+{
+    return checked_integer_from_number<uint16_t>(glua->tryGetNumber(stack_index));
+}
 
 auto GluaResolver<uint32_t>::as(GluaBase* glua, int stack_index) -> uint32_t
 {
@@ -104,6 +186,11 @@ auto GluaResolver<uint32_t>::push(GluaBase* glua, uint32_t value) -> void
 {
     glua->push(value);
 }
+auto GluaResolver<uint32_t>::tryAs(GluaBase* glua, int stack_index)
+    -> std::optional<uint32_t>
+{
+    return checked_integer_from_number<uint32_t>(glua->tryGetNumber(stack_index));
+}
 
 auto GluaResolver<uint64_t>::as(GluaBase* glua, int stack_index) -> uint64_t
 {
@@ -117,6 +204,29 @@ auto GluaResolver<uint64_t>::push(GluaBase* glua, uint64_t value) -> void
 {
     glua->push(value);
 }
+auto GluaResolver<uint64_t>::tryAs(GluaBase* glua, int stack_index)
+    -> std::optional<uint64_t>
+{
+    // pushing a uint64_t beyond the signed range wraps it, so wrap it back
+    auto integer = glua->tryGetInteger(stack_index);
+
+    if (integer.has_value()) {
+        return static_cast<uint64_t>(integer.value());
+    }
+
+    auto number = glua->tryGetNumber(stack_index);
+
+    if (number.has_value()) {
+        return checked_integer_from_number<uint64_t>(number);
+    }
+
+    // backends may box 64 bit integers that numbers can't represent
+    if (glua->isUInt64(stack_index)) {
+        return glua->getUInt64(stack_index);
+    }
+
+    return std::nullopt;
+}
 
 auto GluaResolver<float>::as(GluaBase* glua, int stack_index) -> float
 {
@@ -130,6 +240,17 @@ auto GluaResolver<float>::push(GluaBase* glua, float value) -> void
 {
     glua->push(value);
 }
+auto GluaResolver<float>::tryAs(GluaBase* glua, int stack_index)
+    -> std::optional<float>
+{
+    auto number = glua->tryGetNumber(stack_index);
+
+    if (number.has_value()) {
+        return static_cast<float>(number.value());
+    }
+
+    return std::nullopt;
+}
 
 auto GluaResolver<double>::as(GluaBase* glua, int stack_index) -> double
 {
@@ -143,6 +264,17 @@ auto GluaResolver<double>::push(GluaBase* glua, double value) -> void
 {
     glua->push(value);
 }
+auto GluaResolver<double>::tryAs(GluaBase* glua, int stack_index)
+    -> std::optional<double>
+{
+    auto number = glua->tryGetNumber(stack_index);
+
+    if (number.has_value()) {
+        return static_cast<double>(number.value());
+    }
+
+    return std::nullopt;
+}
 
 auto GluaResolver<const char*>::as(GluaBase* glua, int stack_index) -> const
     char*
@@ -158,6 +290,17 @@ auto GluaResolver<const char*>::push(GluaBase* glua, const char* value)
 {
     glua->push(value);
 }
+auto GluaResolver<const char*>::tryAs(GluaBase* glua, int stack_index)
+    -> std::optional<const char*>
+{
+    auto string = glua->tryGetStringView(stack_index);
+
+    if (string.has_value()) {
+        return string->data(); // always null terminated
+    }
+
+    return std::nullopt;
+}
 
 auto GluaResolver<std::string_view>::as(GluaBase* glua, int stack_index)
     -> std::string_view
@@ -174,6 +317,11 @@ auto GluaResolver<std::string_view>::push(GluaBase* glua,
 {
     glua->push(value);
 }
+auto GluaResolver<std::string_view>::tryAs(GluaBase* glua, int stack_index)
+    -> std::optional<std::string_view>
+{
+    return glua->tryGetStringView(stack_index);
+}
 
 auto GluaResolver<std::string>::as(GluaBase* glua, int stack_index)
     -> std::string
@@ -189,4 +337,72 @@ auto GluaResolver<std::string>::push(GluaBase* glua, const std::string& value)
 {
     glua->push(value);
 }
+auto GluaResolver<std::string>::tryAs(GluaBase* glua, int stack_index)
+    -> std::optional<std::string>
+{
+    auto string = glua->tryGetStringView(stack_index);
+
+    if (string.has_value()) {
+        return std::string { string.value() };
+    }
+
+    return std::nullopt;
+}
+auto GluaResolver<std::string>::asInto(GluaBase* glua, int stack_index,
+    std::string& out) -> void
+{
+    // assign reuses the existing capacity
+    out.assign(glua->getStringView(stack_index));
+}
+
+auto GluaResolver<LuaTableView>::as(GluaBase* glua, int stack_index)
+    -> LuaTableView
+{
+    return LuaTableView { glua, stack_index };
+}
+auto GluaResolver<LuaTableView>::is(GluaBase* glua, int stack_index) -> bool
+{
+    return glua->isMap(stack_index);
+}
+auto GluaResolver<LuaTableView>::push(GluaBase* glua, const LuaTableView& value)
+    -> void
+{
+    glua->pushValueCopy(value.GetStackIndex());
+}
+
+auto GluaResolver<std::monostate>::as(GluaBase* /*unused*/, int /*unused*/)
+    -> std::monostate
+{
+    return std::monostate {};
+}
+auto GluaResolver<std::monostate>::is(GluaBase* glua, int stack_index) -> bool
+{
+    return glua->isNull(stack_index);
+}
+auto GluaResolver<std::monostate>::push(GluaBase* glua,
+    std::monostate /*unused*/) -> void
+{
+    glua->push(std::nullopt);
+}
+
+auto parse_struct_field_names(std::string_view member_names)
+    -> std::vector<std::string>
+{
+    auto comma_separated = string_util::remove_all_whitespace(member_names);
+
+    std::vector<std::string> result;
+
+    for (auto member : string_util::split(comma_separated, std::string_view { "," })) {
+        auto last_scope = member.rfind("::");
+
+        if (last_scope == std::string_view::npos) {
+            throw std::logic_error("GLUA_STRUCT had member of invalid format, "
+                                   "expecting &StructName::member_name");
+        }
+
+        result.emplace_back(member.substr(last_scope + 2));
+    }
+
+    return result;
+}
 } // namespace kdk::glua
@@ -1,132 +1,195 @@
 #include "glua/GluaLua.h"
 #include "glua/FileUtil.h"
+#include "glua/LuaCompat.h"
 
-#include <iostream>
-
-namespace kdk::glua {
-auto LuaStateDeleter::operator()(lua_State* state) -> void
-{
-    if (state != nullptr) {
-        lua_close(state);
-    }
-}
-
-static auto glua_capture_print(lua_State* lua) -> int
-{
-    auto arg_count = lua_gettop(lua);
-    auto& ostream = *static_cast<std::ostream*>(lua_touserdata(lua, lua_upvalueindex(1)));
-
-    for (auto i = 1; i <= arg_count; ++i) {
-        ostream << lua_tostring(lua, i);
-    }
-
-    ostream << std::endl; // print ends with newline
-
-    return 0;
-}
-
-static auto glua_set_environment_to_stack(
-    lua_State* lua, const std::vector<std::string>& environment) -> void
-{
-    // table we're setting is currently top  (-1) on stack
-
-    for (const auto& str : environment) {
-        lua_pushlstring(lua, str.data(), str.length());
-        lua_getglobal(lua, str.data());
-        lua_settable(lua, -3);
-    }
-
-    // set global env value to same table
-    lua_pushliteral(lua, "_G");
-    lua_pushvalue(lua, -2);
-    lua_settable(lua, -3);
+extern "C" {
+#include "luajit.h"
 }
 
-static auto
-glua_set_sub_environment_to_stack(lua_State* lua, std::string_view parent_table, const std::vector<std::string>& environment) -> void
-{
-    // table we're setting is currently top  (-1) on stack
-
-    lua_pushlstring(lua, parent_table.data(), parent_table.size());
-    lua_createtable(lua, 0, static_cast<int>(environment.size()));
-
-    for (const auto& str : environment) {
-        lua_pushlstring(lua, str.data(), str.length());
-
-        lua_getglobal(lua, parent_table.data());
-        lua_pushlstring(lua, str.data(), str.length());
-        lua_gettable(lua, -2);
-
-        lua_remove(lua, -2); // remove parent table from stack
-
-        lua_settable(lua, -3);
-    }
+#include <cstring>
+#include <new>
+#include <utility>
 
-    lua_settable(lua, -3);
-}
+namespace kdk::glua {
+// LuaJIT's lua_type for cdata, which lua.h doesn't define
+static constexpr int lua_type_cdata = 10;
+
+// pairs and ipairs honouring __pairs and __ipairs metamethods as in Lua 5.2,
+// so container proxies can be iterated like tables
+static constexpr auto container_iteration_script = R"lua(
+local raw_pairs, raw_ipairs, getmetatable, type = pairs, ipairs, getmetatable, type
+
+pairs = function(value)
+    local metatable = getmetatable(value)
+
+    if type(metatable) == "table" and metatable.__pairs ~= nil then
+        return metatable.__pairs(value)
+    end
+
+    return raw_pairs(value)
+end
+
+ipairs = function(value)
+    local metatable = getmetatable(value)
+
+    if type(metatable) == "table" and metatable.__ipairs ~= nil then
+        return metatable.__ipairs(value)
+    end
+
+    return raw_ipairs(value)
+end
+)lua";
+
+static constexpr auto ffi_owner_metatable_name = "__libglua__ffi_owner__";
+
+// buffers are cdata structs of a data pointer and size, with metamethods so
+// they index like the pointer. Owners are anchored in a weak keyed table so
+// they live exactly as long as their buffer
+static constexpr auto ffi_bridge_script = R"lua(
+local ffi = require("ffi")
+local buffer_types = {}
+local anchors = setmetatable({}, { __mode = "k" })
+
+-- C++ writes 64 bit integers here before boxing them
+local integer_box = ffi.new("uint64_t[1]")
+local signed_integer_box = ffi.cast("int64_t*", integer_box)
+
+local buffer_metamethods = {
+    __index = function(buffer, index) return buffer.data[index] end,
+    __newindex = function(buffer, index, value) buffer.data[index] = value end,
+    __len = function(buffer) return tonumber(buffer.size) end,
+}
+
+local function buffer_type(element_type_name)
+    local buffer_ctype = buffer_types[element_type_name]
+
+    if buffer_ctype == nil then
+        buffer_ctype = ffi.metatype(
+            ffi.typeof("struct { $ *data; size_t size; }", ffi.typeof(element_type_name)),
+            buffer_metamethods)
+        buffer_types[element_type_name] = buffer_ctype
+    end
+
+    return buffer_ctype
+end
+
+return {
+    define = function(type_name, cdef)
+        ffi.cdef(cdef)
+        return ffi.sizeof(type_name)
+    end,
+    push = function(element_type_name, data, size, owner)
+        local buffer = buffer_type(element_type_name)(data, size)
+
+        if owner ~= nil then
+            anchors[buffer] = owner
+        end
+
+        return buffer
+    end,
+    integer_box = integer_box,
+    box_int64 = function()
+        return signed_integer_box[0]
+    end,
+    box_uint64 = function()
+        return integer_box[0]
+    end,
+    -- the boxed integer's type, or nil for anything else
+    is_boxed_integer = function(value)
+        if ffi.istype("int64_t", value) then
+            return "int64_t"
+        elseif ffi.istype("uint64_t", value) then
+            return "uint64_t"
+        end
+        return nil
+    end,
+    cast = function(signature, address)
+        return ffi.cast(signature, address)
+    end,
+    is = function(element_type_name, value)
+        local buffer_ctype = buffer_types[element_type_name]
+        return buffer_ctype ~= nil and ffi.istype(buffer_ctype, value)
+    end,
+}
+)lua";
+
+// native layout of the cdata buffer struct declared by the bridge script
+struct FfiBufferLayout {
+    void* data;
+    size_t size;
+};
+
+// builds the jit.attach handler, which resolves each event's location and
+// abort reason before handing it to the C++ recorder
+static constexpr auto trace_handler_script = R"lua(
+local record = ...
+local funcinfo = require("jit.util").funcinfo
+local has_vmdef, vmdef = pcall(require, "jit.vmdef")
+
+local function format_abort_reason(error, info)
+    if type(error) == "number" and has_vmdef then
+        if type(info) == "function" then
+            info = funcinfo(info).loc
+        end
+
+        return string.format(vmdef.traceerr[error], info)
+    end
+
+    return tostring(error)
+end
+
+return function(what, trace_id, func, pc, other_trace, other_info)
+    local source, line, parent_trace_id, abort_reason = "", 0, 0, ""
+
+    if type(func) == "function" then
+        local info = funcinfo(func, pc)
+        source = info.source or "[C]"
+        line = info.currentline or info.linedefined or 0
+    end
+
+    if what == "start" then
+        parent_trace_id = other_trace or 0
+    elseif what == "abort" then
+        abort_reason = format_abort_reason(other_trace, other_info)
+    end
+
+    record(what, trace_id or 0, source, line, parent_trace_id, abort_reason)
+end
+)lua";
 
 GluaLua::GluaLua(std::ostream& output_stream, bool start_sandboxed)
-    : m_lua(luaL_newstate())
-    , m_output_stream(output_stream)
-    , m_current_array_index(0)
+    : GluaLuaCommon(output_stream)
+    , m_integer_box(nullptr)
+    , m_int64_mode(Int64Mode::NUMBER)
+    , m_trace_report(std::make_unique<JitTraceReport>())
 {
-    luaL_openlibs(m_lua.get());
-
-    luaL_Reg print_override_lib[] = { { "print", glua_capture_print },
-        { nullptr, nullptr } };
+    // must replace pairs and ipairs before the sandbox copies them
+    if (luaL_dostring(m_lua.get(), container_iteration_script) != 0) {
+        throw exceptions::LuaException(
+            std::string { "Failed to set up container iteration: " } + lua_tostring(m_lua.get(), -1));
+    }
 
-    // create sandbox environment
-    lua_newtable(m_lua.get());
+    SandboxEnvironment sandbox_environment;
 
-    std::vector<std::string> sandbox_environment {
+    sandbox_environment.globals = {
         "assert", "error", "ipairs", "next", "pairs",
         "pcall", "print", "select", "tonumber", "tostring",
         "type", "unpack", "_VERSION", "xpcall", "isfunction"
     };
-    std::vector<std::string> sandbox_coroutine_environment {
-        "create", "resume", "running", "status", "wrap", "yield"
-    };
-    std::vector<std::string> sandbox_io_environment { "read", "write", "flush",
-        "type" };
-    std::vector<std::string> sandbox_string_environment {
-        "byte", "char", "dump", "find", "format", "gmatch", "gsub",
-        "len", "lower", "match", "rep", "reverse", "sub", "upper"
-    };
-    std::vector<std::string> sandbox_table_environment { "insert", "maxn", "remove",
-        "sort" };
-    std::vector<std::string> sandbox_math_environment {
-        "abs", "acos", "asin", "atan", "atan2", "ceil", "cos", "cosh",
-        "deg", "exp", "floor", "fmod", "frexp", "huge", "ldexp", "log",
-        "log10", "max", "min", "modf", "pi", "pow", "rad", "random",
-        "sin", "sinh", "sqrt", "tan", "tanh"
+    sandbox_environment.libraries = {
+        { "coroutine", { "create", "resume", "running", "status", "wrap", "yield" } },
+        { "io", { "read", "write", "flush", "type" } },
+        { "string", { "byte", "char", "dump", "find", "format", "gmatch", "gsub",
+                        "len", "lower", "match", "rep", "reverse", "sub", "upper" } },
+        { "table", { "insert", "maxn", "remove", "sort" } },
+        { "math", { "abs", "acos", "asin", "atan", "atan2", "ceil", "cos", "cosh",
+                      "deg", "exp", "floor", "fmod", "frexp", "huge", "ldexp", "log",
+                      "log10", "max", "min", "modf", "pi", "pow", "rad", "random",
+                      "sin", "sinh", "sqrt", "tan", "tanh" } },
+        { "os", { "clock", "difftime", "time" } }
     };
-    std::vector<std::string> sandbox_os_environment { "clock", "difftime", "time" };
-
-    glua_set_environment_to_stack(m_lua.get(), sandbox_environment);
-    glua_set_sub_environment_to_stack(m_lua.get(), "coroutine",
-        sandbox_coroutine_environment);
-    glua_set_sub_environment_to_stack(m_lua.get(), "io", sandbox_io_environment);
-    glua_set_sub_environment_to_stack(m_lua.get(), "string",
-        sandbox_string_environment);
-    glua_set_sub_environment_to_stack(m_lua.get(), "table",
-        sandbox_table_environment);
-    glua_set_sub_environment_to_stack(m_lua.get(), "math",
-        sandbox_math_environment);
-    glua_set_sub_environment_to_stack(m_lua.get(), "os", sandbox_os_environment);
-
-    lua_pushlightuserdata(m_lua.get(), &m_output_stream.get());
-    luaL_setfuncs(m_lua.get(), print_override_lib, 1);
-
-    lua_setglobal(m_lua.get(), "__libglua__sandbox__");
-
-    // now that sandbox is set up, reset environment
-    ResetEnvironment(start_sandboxed);
-
-    // put print override on the non-sandbox _G as well
-    lua_getglobal(m_lua.get(), "_G");
-    lua_pushlightuserdata(m_lua.get(), &m_output_stream.get());
-    luaL_setfuncs(m_lua.get(), print_override_lib, 1);
-    lua_pop(m_lua.get(), 1);
+
+    setUpSandbox(sandbox_environment, start_sandboxed);
 
     lua_pushlightuserdata(m_lua.get(), this);
     lua_setglobal(m_lua.get(), "LuaClass");
@@ -139,544 +202,387 @@ auto GluaLua::GetInstanceFromState(lua_State* lua) -> GluaLua&
 
     return *lua_object;
 }
-auto GluaLua::ResetEnvironment(bool sandboxed) -> void
+auto GluaLua::SetJitEnabled(bool enabled) -> void
 {
-    if (sandboxed) {
-        lua_getglobal(m_lua.get(), "__libglua__sandbox__");
-    } else {
-        lua_getglobal(m_lua.get(), "_G");
-    }
+    auto mode = LUAJIT_MODE_ENGINE | (enabled ? LUAJIT_MODE_ON : LUAJIT_MODE_OFF);
 
-    lua_newtable(m_lua.get()); // env
-    lua_pushvalue(m_lua.get(), -1); // env -> env
-    lua_pushliteral(m_lua.get(), "__index"); // env -> env -> __index
-    lua_pushvalue(m_lua.get(), -4); // push (__libglua__sandbox__ or _G), env ->
-        // env -> __index -> sandbox
-    lua_settable(m_lua.get(), -3); // env -> env
-    lua_setmetatable(m_lua.get(), -2); // env
-
-    lua_setglobal(m_lua.get(), "__libglua__env__");
+    if (luaJIT_setmode(m_lua.get(), 0, mode) == 0) {
+        throw exceptions::LuaException("Failed to set the JIT mode");
+    }
 }
-auto GluaLua::RegisterCallable(const std::string& name, Callable callable)
-    -> void
+auto GluaLua::SetFunctionJitEnabled(const std::string& function_name,
+    bool enabled, bool include_subfunctions) -> void
 {
-    auto insert_pair = m_registry.emplace(std::string { name },
-        std::move(callable).AcquireCallable());
-
-    if (insert_pair.second) {
-        auto* callable_ptr = insert_pair.first->second.get();
-        lua_pushlightuserdata(m_lua.get(), callable_ptr);
-        lua_pushcclosure(m_lua.get(), call_callable_from_lua, 1);
-
-        // set the closure on the sandbox environment
-        lua_getglobal(m_lua.get(), "__libglua__sandbox__");
-        lua_pushlstring(m_lua.get(), name.data(), name.size());
-        lua_pushvalue(m_lua.get(), -3); // push closer back on stack
-        lua_settable(m_lua.get(), -3);
+    pushValueOfGlobalOntoStack(function_name);
+
+    if (!lua_isfunction(m_lua.get(), -1)) {
         lua_pop(m_lua.get(), 1);
+        throw exceptions::LuaException("Attempted to set the JIT mode of " + function_name + " which was not a function");
+    }
 
-        // now the original closure is all that's left on the stack, set to global
-        // env too
-        lua_setglobal(m_lua.get(), name.data());
-    } else {
-        throw exceptions::LuaException(
-            "Registered a callable with an already used name");
+    auto mode = (include_subfunctions ? LUAJIT_MODE_ALLFUNC : LUAJIT_MODE_FUNC)
+        | (enabled ? LUAJIT_MODE_ON : LUAJIT_MODE_OFF);
+    auto result = luaJIT_setmode(m_lua.get(), -1, mode);
+
+    lua_pop(m_lua.get(), 1);
+
+    if (result == 0) {
+        throw exceptions::LuaException("Failed to set the JIT mode of " + function_name);
     }
 }
-auto GluaLua::push(std::nullopt_t /*unused*/) -> void
+auto GluaLua::FlushJit() -> void
 {
-    lua_pushnil(m_lua.get());
+    luaJIT_setmode(m_lua.get(), 0, LUAJIT_MODE_ENGINE | LUAJIT_MODE_FLUSH);
 }
-auto GluaLua::push(bool value) -> void
+auto GluaLua::SetJitOptions(const JitOptions& options) -> void
 {
-    lua_pushboolean(m_lua.get(), value ? 1 : 0);
-}
-auto GluaLua::push(int8_t value) -> void
-{
-    lua_pushinteger(m_lua.get(), value);
-}
-auto GluaLua::push(int16_t value) -> void
-{
-    lua_pushinteger(m_lua.get(), value);
-}
-auto GluaLua::push(int32_t value) -> void
-{
-    lua_pushinteger(m_lua.get(), value);
-}
-auto GluaLua::push(int64_t value) -> void
-{
-    lua_pushinteger(m_lua.get(), value);
-}
-auto GluaLua::push(uint8_t value) -> void
-{
-    lua_pushinteger(m_lua.get(), static_cast<lua_Integer>(value));
-}
-auto GluaLua::push(uint16_t value) -> void
-{
-    lua_pushinteger(m_lua.get(), static_cast<lua_Integer>(value));
-}
-auto GluaLua::push(uint32_t value) -> void
-{
-    lua_pushinteger(m_lua.get(), static_cast<lua_Integer>(value));
-}
-auto GluaLua::push(uint64_t value) -> void
-{
-    lua_pushinteger(m_lua.get(), static_cast<lua_Integer>(value));
-}
-auto GluaLua::push(float value) -> void
-{
-    lua_pushnumber(m_lua.get(), static_cast<double>(value));
-}
-auto GluaLua::push(double value) -> void { lua_pushnumber(m_lua.get(), value); }
-auto GluaLua::push(const char* value) -> void
-{
-    lua_pushstring(m_lua.get(), value);
-}
-auto GluaLua::push(std::string_view value) -> void
-{
-    lua_pushlstring(m_lua.get(), value.data(), value.size());
-}
-auto GluaLua::push(std::string value) -> void
-{
-    lua_pushlstring(m_lua.get(), value.data(), value.size());
-}
-auto GluaLua::pushArray(size_t size_hint) -> void
-{
-    lua_createtable(m_lua.get(), static_cast<int>(size_hint), 0);
-}
-auto GluaLua::pushStartMap(size_t size_hint) -> void
-{
-    lua_createtable(m_lua.get(), 0, static_cast<int>(size_hint));
-}
-auto GluaLua::arraySetFromStack() -> void
-{
-    // top of stack: value
-    // top -1: index
-    // top -2: table
-    lua_settable(m_lua.get(), -3);
-}
-auto GluaLua::mapSetFromStack() -> void
-{
-    // top of stack: value
-    // top -1: key
-    // top -2: table
-    lua_settable(m_lua.get(), -3);
-}
-auto GluaLua::pushUserType(const std::string& unique_type_name,
-    std::unique_ptr<IManagedTypeStorage> user_storage)
-    -> void
-{
-    auto** managed_type_ptr = static_cast<IManagedTypeStorage**>(
-        lua_newuserdata(m_lua.get(), sizeof(IManagedTypeStorage*)));
+    auto arguments = options.ToArguments();
 
-    *managed_type_ptr = user_storage.get();
-    user_storage.release();
+    lua_getglobal(m_lua.get(), "jit");
+    lua_getfield(m_lua.get(), -1, "opt");
+    lua_getfield(m_lua.get(), -1, "start");
+    lua_remove(m_lua.get(), -2); // remove jit.opt from stack
+    lua_remove(m_lua.get(), -2); // remove jit from stack
 
-    // set the metatable for this object
-    luaL_getmetatable(m_lua.get(), unique_type_name.data());
+    for (const auto& argument : arguments) {
+        lua_pushlstring(m_lua.get(), argument.data(), argument.size());
+    }
 
-    if (lua_isnil(m_lua.get(), -1)) {
+    if (lua_pcall(m_lua.get(), static_cast<int>(arguments.size()), 0, 0) != 0) {
+        std::string error = lua_tostring(m_lua.get(), -1);
         lua_pop(m_lua.get(), 1);
 
-        // reacquire the pointer as a unique pointer to delete it when leaving scope
-        std::unique_ptr<IManagedTypeStorage> reacquired_memory { *managed_type_ptr };
-
-        throw std::runtime_error(
-            "Pushing class type which has not been registered [null metatable]! " + unique_type_name);
+        throw exceptions::LuaException("Failed to set JIT options: " + error);
     }
-
-    lua_setmetatable(m_lua.get(), -2);
 }
-auto GluaLua::getBool(int stack_index) const -> bool
+auto GluaLua::SetTraceDiagnosticsEnabled(bool enabled) -> void
 {
-    return static_cast<bool>(lua_toboolean(m_lua.get(), stack_index));
-}
-auto GluaLua::getInt8(int stack_index) const -> int8_t
-{
-    return static_cast<int8_t>(lua_tointeger(m_lua.get(), stack_index));
-}
-auto GluaLua::getInt16(int stack_index) const -> int16_t
-{
-    return static_cast<int16_t>(lua_tointeger(m_lua.get(), stack_index));
-}
-auto GluaLua::getInt32(int stack_index) const -> int32_t
-{
-    return static_cast<int32_t>(lua_tointeger(m_lua.get(), stack_index));
-}
-auto GluaLua::getInt64(int stack_index) const -> int64_t
-{
-    return static_cast<int64_t>(lua_tointeger(m_lua.get(), stack_index));
-}
-auto GluaLua::getUInt8(int stack_index) const -> uint8_t
-{
-    return static_cast<uint8_t>(lua_tointeger(m_lua.get(), stack_index));
-}
-auto GluaLua::getUInt16(int stack_index) const -> uint16_t
-{
-    return static_cast<uint16_t>(lua_tointeger(m_lua.get(), stack_index));
-}
-auto GluaLua::getUInt32(int stack_index) const -> uint32_t
-{
-    return static_cast<uint32_t>(lua_tointeger(m_lua.get(), stack_index));
-}
-auto GluaLua::getUInt64(int stack_index) const -> uint64_t
-{
-    return static_cast<uint64_t>(lua_tointeger(m_lua.get(), stack_index));
+    if (enabled == m_trace_handler_ref.has_value()) {
+        return;
+    }
+
+    lua_getglobal(m_lua.get(), "jit");
+    lua_getfield(m_lua.get(), -1, "attach");
+    lua_remove(m_lua.get(), -2); // remove jit from stack
+
+    if (enabled) {
+        if (luaL_loadstring(m_lua.get(), trace_handler_script) != 0) {
+            std::string error = lua_tostring(m_lua.get(), -1);
+            lua_pop(m_lua.get(), 2);
+
+            throw exceptions::LuaException("Failed to load the trace handler: " + error);
+        }
+
+        lua_pushlightuserdata(m_lua.get(), m_trace_report.get());
+        lua_pushcclosure(m_lua.get(), record_jit_trace_event, 1);
+
+        if (lua_pcall(m_lua.get(), 1, 1, 0) != 0) {
+            std::string error = lua_tostring(m_lua.get(), -1);
+            lua_pop(m_lua.get(), 2);
+
+            throw exceptions::LuaException("Failed to create the trace handler: " + error);
+        }
+
+        lua_pushvalue(m_lua.get(), -1);
+        m_trace_handler_ref = luaL_ref(m_lua.get(), LUA_REGISTRYINDEX);
+
+        lua_pushliteral(m_lua.get(), "trace");
+        lua_call(m_lua.get(), 2, 0); // jit.attach(handler, "trace")
+    } else {
+        // attaching a handler with no events detaches it
+        lua_rawgeti(m_lua.get(), LUA_REGISTRYINDEX, m_trace_handler_ref.value());
+        lua_call(m_lua.get(), 1, 0);
+
+        luaL_unref(m_lua.get(), LUA_REGISTRYINDEX, m_trace_handler_ref.value());
+        m_trace_handler_ref = std::nullopt;
+    }
 }
-auto GluaLua::getFloat(int stack_index) const -> float
+auto GluaLua::GetTraceReport() const -> const JitTraceReport&
 {
-    return static_cast<float>(lua_tonumber(m_lua.get(), stack_index));
+    return *m_trace_report;
 }
-auto GluaLua::getDouble(int stack_index) const -> double
+auto GluaLua::ClearTraceReport() -> void { m_trace_report->Clear(); }
+auto GluaLua::SetInt64Mode(Int64Mode mode) -> void { m_int64_mode = mode; }
+auto GluaLua::GetInt64Mode() const -> Int64Mode { return m_int64_mode; }
+auto GluaLua::push(int64_t value) -> void
 {
-    return static_cast<double>(lua_tonumber(m_lua.get(), stack_index));
+    // doubles represent every integer up to 2^53 exactly
+    constexpr int64_t max_exact = int64_t { 1 } << 53;
+
+    if (m_int64_mode == Int64Mode::CDATA
+        || (m_int64_mode == Int64Mode::CDATA_WHEN_INEXACT
+            && (value > max_exact || value < -max_exact))) {
+        pushBoxedInteger(static_cast<uint64_t>(value), false);
+    } else {
+        lua_pushinteger(m_lua.get(), value);
+    }
 }
-auto GluaLua::getCharPointer(int stack_index) const -> const char*
+auto GluaLua::push(uint64_t value) -> void
 {
-    return lua_tostring(m_lua.get(), stack_index);
+    constexpr uint64_t max_exact = uint64_t { 1 } << 53;
+
+    if (m_int64_mode == Int64Mode::CDATA
+        || (m_int64_mode == Int64Mode::CDATA_WHEN_INEXACT && value > max_exact)) {
+        pushBoxedInteger(value, true);
+    } else {
+        lua_pushinteger(m_lua.get(), static_cast<lua_Integer>(value));
+    }
 }
-auto GluaLua::getStringView(int stack_index) const -> std::string_view
+auto GluaLua::defineFfiType(const std::string& type_name,
+    const std::string& cdef, size_t expected_size) -> void
 {
-    size_t length;
-    const auto* c_str = lua_tolstring(m_lua.get(), stack_index, &length);
+    pushFfiBridgeFunction("define");
+    lua_pushlstring(m_lua.get(), type_name.data(), type_name.size());
+    lua_pushlstring(m_lua.get(), cdef.data(), cdef.size());
+    callFfiBridgeFunction(2, 1);
 
-    std::string_view ret_val { c_str, length };
+    auto ffi_size = static_cast<size_t>(lua_tonumber(m_lua.get(), -1));
+    lua_pop(m_lua.get(), 1);
 
-    return ret_val;
+    if (ffi_size != expected_size) {
+        throw exceptions::LuaException("FFI type " + type_name + " has size "
+            + std::to_string(ffi_size) + " but the C++ type has size "
+            + std::to_string(expected_size) + ", are all fields listed? [" + cdef + "]");
+    }
 }
-auto GluaLua::getString(int stack_index) const -> std::string
+auto GluaLua::pushFfiBuffer(const std::string& element_type_name, void* data,
+    size_t size, std::shared_ptr<const void> owner) -> void
 {
-    size_t length;
-    const auto* c_str = lua_tolstring(m_lua.get(), stack_index, &length);
+    pushFfiBridgeFunction("push");
+    lua_pushlstring(m_lua.get(), element_type_name.data(),
+        element_type_name.size());
+    lua_pushlightuserdata(m_lua.get(), data);
+    lua_pushnumber(m_lua.get(), static_cast<lua_Number>(size));
 
-    std::string ret_val { c_str, length };
+    if (owner) {
+        new (lua_compat::new_userdata(m_lua.get(), sizeof(std::shared_ptr<const void>)))
+            std::shared_ptr<const void>(std::move(owner));
 
-    return ret_val;
-}
-auto GluaLua::getArraySize(int stack_index) const -> size_t
-{
-    if (lua_istable(m_lua.get(), stack_index)) {
-        return lua_objlen(m_lua.get(), stack_index);
+        luaL_getmetatable(m_lua.get(), ffi_owner_metatable_name);
+        lua_setmetatable(m_lua.get(), -2);
+    } else {
+        lua_pushnil(m_lua.get());
     }
 
-    throw exceptions::LuaException("GetArraySize for non-table value");
+    callFfiBridgeFunction(4, 1);
 }
-auto GluaLua::getArrayValue(size_t index_into_array,
-    int stack_index_of_array) const -> void
+auto GluaLua::registerFfiFunctionImpl(const std::string& name,
+    const std::string& signature, void* function) -> void
 {
-    auto absolute_array_index = absoluteIndex(stack_index_of_array);
-    lua_pushinteger(m_lua.get(), static_cast<lua_Integer>(index_into_array));
-    lua_gettable(m_lua.get(), absolute_array_index);
+    if (m_registry.count(name) > 0 || m_ffi_function_names.count(name) > 0) {
+        throw exceptions::LuaException(
+            "Registered an FFI function with an already used callable name");
+    }
+
+    pushFfiBridgeFunction("cast");
+    lua_pushlstring(m_lua.get(), signature.data(), signature.size());
+    lua_pushlightuserdata(m_lua.get(), function);
+    callFfiBridgeFunction(2, 1);
+
+    setRegisteredGlobalFromTopOfStack(name);
+    m_ffi_function_names.emplace(name);
 }
-auto GluaLua::getMapKeys(int stack_index) const -> std::vector<std::string>
+auto GluaLua::getInt64(int stack_index) const -> int64_t
 {
-    auto absolute_map_index = absoluteIndex(stack_index);
-    if (lua_istable(m_lua.get(), stack_index)) {
-        auto size = lua_objlen(m_lua.get(), stack_index);
+    if (lua_type(m_lua.get(), stack_index) == lua_type_cdata) {
+        auto boxed = getBoxedInteger(stack_index);
 
-        std::vector<std::string> result;
-        result.reserve(size);
+        if (!boxed.has_value()) {
+            return 0;
+        }
 
-        // push first nil key to start iteration
-        lua_pushnil(m_lua.get());
-        while (lua_next(m_lua.get(), absolute_map_index) != 0) {
-            // key then value were pushed onto stack
-            lua_pop(m_lua.get(), 1); // pop off value, we're not looking
-
-            if (lua_isstring(m_lua.get(), -1) != 0) {
-                size_t str_len = 0;
-                const char* str = lua_tolstring(m_lua.get(), -1, &str_len);
-                result.emplace_back(str, str_len);
-            } else {
-                // key isn't string, lua_tolstring will convert it to a string and mess
-                // up iteration, create copy
-                lua_pushvalue(m_lua.get(), -1);
-
-                size_t str_len = 0;
-                const char* str = lua_tolstring(m_lua.get(), -1, &str_len);
-                result.emplace_back(str, str_len);
-
-                // now pop off copy
-                lua_pop(m_lua.get(), 1);
-            }
+        if (!boxed->fitsInt64()) {
+            throw exceptions::GluaTypeException(
+                "uint64_t value " + std::to_string(boxed->bits) + " out of int64_t range");
         }
 
-        return result;
+        return static_cast<int64_t>(boxed->bits);
     }
 
-    throw exceptions::LuaException("GetMapKeys for non-table value");
-}
-auto GluaLua::getMapValue(const std::string& key, int stack_index_of_map) const
-    -> void
-{
-    auto absolute_map_index = absoluteIndex(stack_index_of_map);
-    lua_pushlstring(m_lua.get(), key.data(), key.size());
-    lua_gettable(m_lua.get(), absolute_map_index);
+    return static_cast<int64_t>(lua_tointeger(m_lua.get(), stack_index));
 }
-auto GluaLua::getUserType(const std::string& unique_type_name,
-    int stack_index) const -> IManagedTypeStorage*
+auto GluaLua::getUInt64(int stack_index) const -> uint64_t
 {
-    auto** managed_type_ptr = static_cast<IManagedTypeStorage**>(
-        luaL_checkudata(m_lua.get(), stack_index, unique_type_name.data()));
+    if (lua_type(m_lua.get(), stack_index) == lua_type_cdata) {
+        auto boxed = getBoxedInteger(stack_index);
+
+        if (!boxed.has_value()) {
+            return 0;
+        }
+
+        if (!boxed->fitsUInt64()) {
+            throw exceptions::GluaTypeException("int64_t value "
+                + std::to_string(static_cast<int64_t>(boxed->bits))
+                + " out of uint64_t range");
+        }
 
-    if (managed_type_ptr != nullptr) {
-        return *managed_type_ptr;
+        return boxed->bits;
     }
 
-    throw exceptions::LuaException(
-        "Tried to get type but invalid value at index!");
-}
-auto GluaLua::isUserType(const std::string& unique_type_name,
-    int stack_index) const -> bool
-{
-    return luaL_checkudata(m_lua.get(), stack_index, unique_type_name.data()) != nullptr;
-}
-auto GluaLua::isNull(int stack_index) const -> bool
-{
-    return lua_isnil(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isBool(int stack_index) const -> bool
-{
-    return lua_isboolean(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isInt8(int stack_index) const -> bool
-{
-    return lua_isnumber(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isInt16(int stack_index) const -> bool
-{
-    return lua_isnumber(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isInt32(int stack_index) const -> bool
-{
-    return lua_isnumber(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isInt64(int stack_index) const -> bool
-{
-    return lua_isnumber(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isUInt8(int stack_index) const -> bool
-{
-    return lua_isnumber(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isUInt16(int stack_index) const -> bool
-{
-    return lua_isnumber(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isUInt32(int stack_index) const -> bool
-{
-    return lua_isnumber(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isUInt64(int stack_index) const -> bool
-{
-    return lua_isnumber(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isFloat(int stack_index) const -> bool
-{
-    return lua_isnumber(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isDouble(int stack_index) const -> bool
-{
-    return lua_isnumber(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isCharPointer(int stack_index) const -> bool
-{
-    return lua_isstring(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isStringView(int stack_index) const -> bool
-{
-    return lua_isstring(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isString(int stack_index) const -> bool
-{
-    return lua_isstring(m_lua.get(), stack_index) != 0;
-}
-auto GluaLua::isArray(int stack_index) const -> bool
-{
-    return lua_istable(m_lua.get(), stack_index) != 0;
+    return static_cast<uint64_t>(lua_tointeger(m_lua.get(), stack_index));
 }
-auto GluaLua::isMap(int stack_index) const -> bool
+auto GluaLua::tryGetInteger(int /*stack_index*/) const
+    -> std::optional<int64_t>
 {
-    return lua_istable(m_lua.get(), stack_index) != 0;
+    // LuaJIT numbers are always doubles, boxed integers are read by getInt64
+    return std::nullopt;
 }
-auto GluaLua::setGlobalFromStack(const std::string& name, int stack_index)
-    -> void
+auto GluaLua::getFfiBuffer(const std::string& element_type_name,
+    int stack_index) const -> std::optional<std::pair<void*, size_t>>
 {
-    auto absolute_value_index = absoluteIndex(stack_index);
-    lua_getglobal(m_lua.get(), "__libglua__env__");
-    lua_pushlstring(m_lua.get(), name.data(), name.size());
-    lua_pushvalue(
-        m_lua.get(),
-        absolute_value_index); // get value from original stack back into position
+    auto absolute_index = lua_compat::absolute_index(m_lua.get(), stack_index);
 
-    lua_settable(m_lua.get(), -3);
+    pushFfiBridgeFunction("is");
+    lua_pushlstring(m_lua.get(), element_type_name.data(),
+        element_type_name.size());
+    lua_pushvalue(m_lua.get(), absolute_index);
+    callFfiBridgeFunction(2, 1);
 
-    lua_pop(m_lua.get(), 1); // env table is still on stack, pop
-}
-auto GluaLua::pushGlobal(const std::string& name) -> void
-{
-    lua_getglobal(m_lua.get(), "__libglua__env__");
-    lua_pushlstring(m_lua.get(), name.data(), name.size());
+    auto is_buffer = lua_toboolean(m_lua.get(), -1) != 0;
+    lua_pop(m_lua.get(), 1);
+
+    if (!is_buffer) {
+        return std::nullopt;
+    }
 
-    lua_gettable(m_lua.get(), -2);
+    // LuaJIT gives the address of the cdata payload for cdata values
+    const auto* buffer = static_cast<const FfiBufferLayout*>(
+        lua_topointer(m_lua.get(), absolute_index));
 
-    lua_remove(m_lua.get(), -2); // remove sandbox env from stack
+    return std::make_pair(buffer->data, buffer->size);
 }
-auto GluaLua::popOffStack(size_t count) -> void
+auto GluaLua::isInt64(int stack_index) const -> bool
 {
-    lua_pop(m_lua.get(), static_cast<int>(count));
+    if (lua_type(m_lua.get(), stack_index) == lua_type_cdata) {
+        auto boxed = getBoxedInteger(stack_index);
+
+        return boxed.has_value() && boxed->fitsInt64();
+    }
+
+    return lua_isnumber(m_lua.get(), stack_index) != 0;
 }
-auto GluaLua::getStackTop() -> int { return lua_gettop(m_lua.get()); }
-auto GluaLua::callScriptFunctionImpl(const std::string& function_name,
-    size_t arg_count) -> void
+auto GluaLua::isUInt64(int stack_index) const -> bool
 {
-    pushValueOfGlobalOntoStack(function_name);
+    if (lua_type(m_lua.get(), stack_index) == lua_type_cdata) {
+        auto boxed = getBoxedInteger(stack_index);
 
-    if (!lua_isfunction(m_lua.get(), -1)) {
-        throw exceptions::LuaException("Attempted to call lua script function " + function_name + " which was not a function");
+        return boxed.has_value() && boxed->fitsUInt64();
     }
 
-    // arg_count arguments were already on the stack, but lua requires the
-    // function before the arguments
-    if (arg_count > 0) {
-        // need to move the function back arg_count layers on the stack
-        lua_insert(m_lua.get(), -1 - static_cast<int>(arg_count));
-    }
+    return lua_isnumber(m_lua.get(), stack_index) != 0;
+}
+auto GluaLua::setEnvironmentOfFunction(int stack_index) -> void
+{
+    auto function_index = lua_compat::absolute_index(m_lua.get(), stack_index);
 
     lua_getglobal(m_lua.get(), "__libglua__env__");
-    lua_setfenv(m_lua.get(), -2);
-    if (lua_pcall(m_lua.get(), static_cast<int>(arg_count), LUA_MULTRET, 0) != 0) {
-        throw exceptions::LuaException("Failed to call lua script function [" + function_name + "]: " + lua_tostring(m_lua.get(), -1));
-    }
+    lua_setfenv(m_lua.get(), function_index);
 }
-auto GluaLua::registerClassImpl(
-    const std::string& class_name,
-    std::unordered_map<std::string, std::unique_ptr<ICallable>>
-        method_callables) -> void
-{
-    luaL_newmetatable(m_lua.get(), class_name.data());
 
-    lua_pushstring(m_lua.get(), "__gc");
-    lua_pushcfunction(m_lua.get(), &destruct_managed_type);
-    lua_settable(m_lua.get(), -3);
+auto GluaLua::pushFfiBridgeFunction(const char* name) const -> void
+{
+    if (!m_ffi_bridge_ref.has_value()) {
+        if (luaL_loadstring(m_lua.get(), ffi_bridge_script) != 0
+            || lua_pcall(m_lua.get(), 0, 1, 0) != 0) {
+            std::string error = lua_tostring(m_lua.get(), -1);
+            lua_pop(m_lua.get(), 1);
 
-    auto pos_pair = m_method_registry.emplace(class_name, std::move(method_callables));
-    auto& our_registry = pos_pair.first->second;
+            throw exceptions::LuaException(
+                "Failed to load the FFI bridge, FFI buffers require LuaJIT: " + error);
+        }
 
-    lua_pushstring(m_lua.get(), "__index");
-    lua_pushvalue(m_lua.get(), -2);
-    lua_settable(m_lua.get(), -3);
+        lua_getfield(m_lua.get(), -1, "integer_box");
+        m_integer_box = const_cast<void*>(lua_topointer(m_lua.get(), -1));
+        lua_pop(m_lua.get(), 1);
 
-    for (auto& method_pair : our_registry) {
-        lua_pushstring(m_lua.get(), method_pair.first.data());
-        auto* callable_ptr = method_pair.second.get();
-        lua_pushlightuserdata(m_lua.get(), callable_ptr);
-        lua_pushcclosure(m_lua.get(), call_callable_from_lua, 1);
+        m_ffi_bridge_ref = luaL_ref(m_lua.get(), LUA_REGISTRYINDEX);
 
-        lua_settable(m_lua.get(), -3);
+        luaL_newmetatable(m_lua.get(), ffi_owner_metatable_name);
+        lua_pushcfunction(m_lua.get(), destruct_ffi_owner);
+        lua_setfield(m_lua.get(), -2, "__gc");
+        lua_pop(m_lua.get(), 1);
     }
 
-    // pop the new metatable off the stack
-    lua_pop(m_lua.get(), 1);
+    lua_rawgeti(m_lua.get(), LUA_REGISTRYINDEX, m_ffi_bridge_ref.value());
+    lua_getfield(m_lua.get(), -1, name);
+    lua_remove(m_lua.get(), -2); // remove bridge table from stack
 }
-auto GluaLua::registerMethodImpl(const std::string& class_name,
-    const std::string& method_name,
-    Callable method) -> void
+auto GluaLua::callFfiBridgeFunction(int arg_count, int result_count) const
+    -> void
 {
-    luaL_getmetatable(m_lua.get(), class_name.data());
-
-    auto pos_pair = m_method_registry[class_name].emplace(
-        method_name, std::move(method).AcquireCallable());
+    if (lua_pcall(m_lua.get(), arg_count, result_count, 0) != 0) {
+        std::string error = lua_tostring(m_lua.get(), -1);
+        lua_pop(m_lua.get(), 1);
 
-    if (pos_pair.second) {
-        lua_pushlstring(m_lua.get(), method_name.data(), method_name.size());
-        auto* callable_ptr = pos_pair.first->second.get();
-        lua_pushlightuserdata(m_lua.get(), callable_ptr);
-        lua_pushcclosure(m_lua.get(), call_callable_from_lua, 1);
-    } else {
-        throw exceptions::LuaException(
-            "Tried to register method with already registered name [" + method_name + "]");
+        throw exceptions::LuaException("FFI bridge call failed: " + error);
     }
-
-    lua_settable(m_lua.get(), -3);
-}
-auto GluaLua::transformObjectIndex(size_t index) -> size_t
-{
-    return index + 1; // lua is one based
 }
-auto GluaLua::transformFunctionParameterIndex(size_t index) -> size_t
-{
-    return index + 1; // function parameter indices start at 1
-}
-auto GluaLua::runScript(std::string_view script_data) -> void
-{
-    auto code = luaL_loadbuffer(m_lua.get(), script_data.data(),
-        script_data.size(), "libglua");
-
-    if (code == 0) {
-        lua_getglobal(m_lua.get(), "__libglua__env__");
-        lua_setfenv(m_lua.get(), -2);
-        code = lua_pcall(m_lua.get(), 0, LUA_MULTRET, 0);
-
-        if (code != 0) {
-            std::string message { "Failed to call script: " };
-            message.append(lua_tostring(m_lua.get(), -1));
-            throw exceptions::LuaException(std::move(message));
-        }
-    } else {
-        throw exceptions::LuaException(std::string { "Failed to load script" }.append(
-            lua_tostring(m_lua.get(), -1)));
-    }
-}
-auto GluaLua::GluaLua::pushValueOfGlobalOntoStack(
-    const std::string& global_name) -> void
-{
-    lua_getglobal(m_lua.get(), "__libglua__env__");
-    lua_pushlstring(m_lua.get(), global_name.data(), global_name.size());
 
-    lua_gettable(m_lua.get(), -2);
+auto GluaLua::pushBoxedInteger(uint64_t bits, bool is_unsigned) -> void
+{
+    pushFfiBridgeFunction(is_unsigned ? "box_uint64" : "box_int64");
 
-    lua_remove(m_lua.get(), -2); // remove sandbox env from stack
+    // the box is set after loading the bridge, the box function reads it
+    std::memcpy(m_integer_box, &bits, sizeof(bits));
+    callFfiBridgeFunction(0, 1);
 }
-auto GluaLua::setValueOfGlobalFromTopOfStack(const std::string& global_name)
-    -> void
+auto GluaLua::getBoxedInteger(int stack_index) const -> std::optional<BoxedInteger>
 {
-    lua_getglobal(m_lua.get(), "__libglua__env__");
-    lua_pushlstring(m_lua.get(), global_name.data(), global_name.size());
-    lua_pushvalue(m_lua.get(),
-        -3); // get value from original stack back into position
+    auto absolute_index = lua_compat::absolute_index(m_lua.get(), stack_index);
 
-    lua_settable(
-        m_lua.get(),
-        -3); // now stack has original value, table, poth should be popped
+    pushFfiBridgeFunction("is_boxed_integer");
+    lua_pushvalue(m_lua.get(), absolute_index);
+    callFfiBridgeFunction(1, 1);
 
-    lua_pop(m_lua.get(), 2);
-}
+    auto is_boxed = lua_type(m_lua.get(), -1) == LUA_TSTRING;
+    auto is_unsigned = is_boxed
+        && std::string_view { lua_tostring(m_lua.get(), -1) } == "uint64_t";
+    lua_pop(m_lua.get(), 1);
 
-auto GluaLua::absoluteIndex(int index) const -> int
-{
-    if (index > 0 || index < LUA_REGISTRYINDEX) {
-        return index;
+    if (!is_boxed) {
+        return std::nullopt;
     }
 
-    return lua_gettop(m_lua.get()) + index + 1;
+    // LuaJIT gives the address of the cdata payload for cdata values
+    BoxedInteger boxed { 0, is_unsigned };
+    std::memcpy(&boxed.bits, lua_topointer(m_lua.get(), absolute_index),
+        sizeof(boxed.bits));
+
+    return boxed;
 }
 
-auto call_callable_from_lua(lua_State* state) -> int
+auto record_jit_trace_event(lua_State* state) -> int
 {
-    auto* callable_ptr = static_cast<ICallable*>(lua_touserdata(state, lua_upvalueindex(1)));
+    auto* report = static_cast<JitTraceReport*>(lua_touserdata(state, lua_upvalueindex(1)));
+
+    return call_protected(state, [state, report]() {
+        std::string_view what = lua_tostring(state, 1);
+
+        auto type = JitTraceEventType::FLUSH;
+        if (what == "start") {
+            type = JitTraceEventType::START;
+        } else if (what == "stop") {
+            type = JitTraceEventType::STOP;
+        } else if (what == "abort") {
+            type = JitTraceEventType::ABORT;
+        }
 
-    callable_ptr->Call();
+        report->AddEvent(JitTraceEvent { type,
+            static_cast<int>(lua_tointeger(state, 2)),
+            static_cast<int>(lua_tointeger(state, 5)),
+            lua_tostring(state, 3),
+            static_cast<int>(lua_tointeger(state, 4)),
+            lua_tostring(state, 6) });
 
-    // C++ only 1 return possible, so either nothing was pushed or 1 item was
-    return callable_ptr->HasReturn() ? 1 : 0;
+        return 0;
+    });
 }
 
-auto destruct_managed_type(lua_State* state) -> int
+auto destruct_ffi_owner(lua_State* state) -> int
 {
-    auto** managed_type_ptr = static_cast<IManagedTypeStorage**>(lua_touserdata(state, 1));
+    using Owner = std::shared_ptr<const void>;
 
-    std::unique_ptr<IManagedTypeStorage> reacquired_memory { *managed_type_ptr };
+    static_cast<Owner*>(lua_touserdata(state, 1))->~Owner();
 
     return 0;
 }
@@ -0,0 +1,140 @@
+#include "glua/GluaLua54.h"
+
+#include <cstring>
+
+namespace kdk::glua {
+static auto throw_ffi_unsupported() -> void
+{
+    throw exceptions::LuaException("FFI buffers and functions require LuaJIT");
+}
+
+GluaLua54::GluaLua54(std::ostream& output_stream, bool start_sandboxed)
+    : GluaLuaCommon(output_stream)
+{
+    // most script allocations die young, which generational mode collects
+    // without the long incremental cycles
+    lua_gc(m_lua.get(), LUA_GCGEN, 0, 0);
+
+    // the same names as the LuaJIT sandbox where Lua 5.4 still has them
+    SandboxEnvironment sandbox_environment;
+
+    sandbox_environment.globals = {
+        "assert", "error", "ipairs", "next", "pairs",
+        "pcall", "print", "select", "tonumber", "tostring",
+        "type", "_VERSION", "xpcall", "isfunction"
+    };
+    sandbox_environment.libraries = {
+        { "coroutine", { "create", "resume", "running", "status", "wrap", "yield" } },
+        { "io", { "read", "write", "flush", "type" } },
+        { "string", { "byte", "char", "dump", "find", "format", "gmatch", "gsub",
+                        "len", "lower", "match", "rep", "reverse", "sub", "upper" } },
+        { "table", { "insert", "remove", "sort", "unpack" } },
+        { "math", { "abs", "acos", "asin", "atan", "ceil", "cos", "deg", "exp",
+                      "floor", "fmod", "huge", "log", "max", "maxinteger", "min",
+                      "mininteger", "modf", "pi", "rad", "random", "sin", "sqrt",
+                      "tan", "tointeger", "type", "ult" } },
+        { "os", { "clock", "difftime", "time" } }
+    };
+
+    setUpSandbox(sandbox_environment, start_sandboxed);
+
+    // unpack moved to table.unpack in 5.2, keep the 5.1 name for scripts
+    // shared with the LuaJIT backend
+    lua_getglobal(m_lua.get(), "__libglua__sandbox__");
+    lua_getfield(m_lua.get(), -1, "table");
+    lua_getfield(m_lua.get(), -1, "unpack");
+    lua_setfield(m_lua.get(), -3, "unpack");
+    lua_pop(m_lua.get(), 2);
+
+    lua_pushlightuserdata(m_lua.get(), this);
+    lua_setglobal(m_lua.get(), "LuaClass");
+}
+auto GluaLua54::GetInstanceFromState(lua_State* lua) -> GluaLua54&
+{
+    lua_getglobal(lua, "LuaClass");
+    auto* lua_object = static_cast<kdk::glua::GluaLua54*>(lua_touserdata(lua, -1));
+    lua_pop(lua, 1);
+
+    return *lua_object;
+}
+auto GluaLua54::push(int64_t value) -> void
+{
+    lua_pushinteger(m_lua.get(), static_cast<lua_Integer>(value));
+}
+auto GluaLua54::push(uint64_t value) -> void
+{
+    // values beyond the signed range wrap, as math.ult and %u expect
+    lua_pushinteger(m_lua.get(), static_cast<lua_Integer>(value));
+}
+auto GluaLua54::defineFfiType(const std::string& /*type_name*/,
+    const std::string& /*cdef*/, size_t /*expected_size*/) -> void
+{
+    throw_ffi_unsupported();
+}
+auto GluaLua54::pushFfiBuffer(const std::string& /*element_type_name*/,
+    void* /*data*/, size_t /*size*/, std::shared_ptr<const void> /*owner*/)
+    -> void
+{
+    throw_ffi_unsupported();
+}
+auto GluaLua54::registerFfiFunctionImpl(const std::string& /*name*/,
+    const std::string& /*signature*/, void* /*function*/) -> void
+{
+    throw_ffi_unsupported();
+}
+auto GluaLua54::getInt64(int stack_index) const -> int64_t
+{
+    return static_cast<int64_t>(lua_tointeger(m_lua.get(), stack_index));
+}
+auto GluaLua54::getUInt64(int stack_index) const -> uint64_t
+{
+    return static_cast<uint64_t>(lua_tointeger(m_lua.get(), stack_index));
+}
+auto GluaLua54::tryGetInteger(int stack_index) const -> std::optional<int64_t>
+{
+    if (lua_isinteger(m_lua.get(), stack_index) == 0) {
+        return std::nullopt;
+    }
+
+    return static_cast<int64_t>(lua_tointeger(m_lua.get(), stack_index));
+}
+auto GluaLua54::getFfiBuffer(const std::string& /*element_type_name*/,
+    int /*stack_index*/) const -> std::optional<std::pair<void*, size_t>>
+{
+    // without LuaJIT no value is an FFI buffer
+    return std::nullopt;
+}
+auto GluaLua54::isInt64(int stack_index) const -> bool
+{
+    return lua_isnumber(m_lua.get(), stack_index) != 0;
+}
+auto GluaLua54::isUInt64(int stack_index) const -> bool
+{
+    return lua_isnumber(m_lua.get(), stack_index) != 0;
+}
+auto GluaLua54::setEnvironmentOfFunction(int stack_index) -> void
+{
+    auto function_index = lua_absindex(m_lua.get(), stack_index);
+
+    // Lua 5.4 functions see their environment through an _ENV upvalue. The
+    // upvalue is shared by every function of a chunk, so they all follow the
+    // current environment together, like setfenv on each of them would.
+    // C functions and functions not using globals have no _ENV
+    for (int upvalue = 1;; ++upvalue) {
+        const auto* name = lua_getupvalue(m_lua.get(), function_index, upvalue);
+
+        if (name == nullptr) {
+            return;
+        }
+
+        lua_pop(m_lua.get(), 1);
+
+        if (std::strcmp(name, "_ENV") == 0) {
+            lua_getglobal(m_lua.get(), "__libglua__env__");
+            lua_setupvalue(m_lua.get(), function_index, upvalue);
+            return;
+        }
+    }
+}
+
+} // namespace kdk::glua
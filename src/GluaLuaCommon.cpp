@@ -0,0 +1,1500 @@
+#include "glua/GluaLuaCommon.h"
+#include "glua/LuaCompat.h"
+#include "glua/ScriptTracer.h"
+
+#include <atomic>
+#include <new>
+#include <optional>
+#include <utility>
+
+namespace kdk::glua {
+auto LuaStateDeleter::operator()(lua_State* state) -> void
+{
+    if (state != nullptr) {
+        lua_close(state);
+    }
+}
+
+// metatable of the userdata whose finalizer counts garbage collections
+static constexpr auto gc_sentinel_metatable_name = "__libglua__gc_sentinel__";
+
+static auto push_gc_sentinel(lua_State* lua) -> void
+{
+    lua_compat::new_userdata(lua, 0);
+    luaL_getmetatable(lua, gc_sentinel_metatable_name);
+    lua_setmetatable(lua, -2);
+}
+
+// finalizer of the unreferenced sentinel, which only a collection reaches:
+// counts it and puts up a new sentinel for the next one
+static auto count_gc_cycle(lua_State* lua) -> int
+{
+    auto* counter = static_cast<std::atomic<uint64_t>*>(lua_touserdata(lua, lua_upvalueindex(1)));
+    counter->store(counter->load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+
+    push_gc_sentinel(lua);
+    lua_pop(lua, 1);
+
+    return 0;
+}
+
+static auto glua_capture_print(lua_State* lua) -> int
+{
+    auto arg_count = lua_gettop(lua);
+
+    // converted in place before any C++ runs, tostring may raise errors
+    for (auto i = 1; i <= arg_count; ++i) {
+        auto type = lua_type(lua, i);
+
+        if (type == LUA_TSTRING || type == LUA_TNUMBER) {
+            continue;
+        }
+
+        // the original tostring, so metamethods like __tostring apply
+        lua_pushvalue(lua, lua_upvalueindex(2));
+        lua_pushvalue(lua, i);
+        lua_call(lua, 1, 1);
+
+        if (lua_isstring(lua, -1) == 0) {
+            return luaL_error(lua, "'tostring' must return a string to 'print'");
+        }
+
+        lua_replace(lua, i);
+    }
+
+    return call_protected(lua, [lua, arg_count]() {
+        auto& target = *static_cast<PrintTarget*>(lua_touserdata(lua, lua_upvalueindex(1)));
+
+        target.line.clear();
+
+        for (auto i = 1; i <= arg_count; ++i) {
+            size_t length = 0;
+            const auto* text = lua_tolstring(lua, i, &length);
+            target.line.append(text, length);
+        }
+
+        target.sink->Write(target.line);
+
+        return 0;
+    });
+}
+
+static auto glua_set_environment_to_stack(
+    lua_State* lua, const std::vector<std::string>& environment) -> void
+{
+    // table we're setting is currently top  (-1) on stack
+
+    for (const auto& str : environment) {
+        lua_pushlstring(lua, str.data(), str.length());
+        lua_getglobal(lua, str.data());
+        lua_settable(lua, -3);
+    }
+
+    // set global env value to same table
+    lua_pushliteral(lua, "_G");
+    lua_pushvalue(lua, -2);
+    lua_settable(lua, -3);
+}
+
+static auto
+glua_set_sub_environment_to_stack(lua_State* lua, std::string_view parent_table, const std::vector<std::string>& environment) -> void
+{
+    // table we're setting is currently top  (-1) on stack
+
+    lua_pushlstring(lua, parent_table.data(), parent_table.size());
+    lua_createtable(lua, 0, static_cast<int>(environment.size()));
+
+    for (const auto& str : environment) {
+        lua_pushlstring(lua, str.data(), str.length());
+
+        lua_getglobal(lua, parent_table.data());
+        lua_pushlstring(lua, str.data(), str.length());
+        lua_gettable(lua, -2);
+
+        lua_remove(lua, -2); // remove parent table from stack
+
+        lua_settable(lua, -3);
+    }
+
+    lua_settable(lua, -3);
+}
+
+static constexpr auto container_proxy_metatable_name = "__libglua__container__";
+
+static constexpr auto thunk_metatable_name = "__libglua__thunk__";
+
+// field of a class metatable holding the set of its registered ancestors
+static constexpr auto ancestors_field_name = "__ancestors";
+
+// layout of the userdata upvalue of a thunk closure, the functor follows the
+// header at functor_offset
+struct ThunkHeader {
+    GluaThunkFunction call;
+    GluaBase* glua;
+    void (*destroy_functor)(void* functor);
+    size_t functor_offset;
+};
+
+static auto glua_create_container_proxy_metatable(lua_State* lua,
+    GluaLuaCommon* glua) -> void
+{
+    luaL_newmetatable(lua, container_proxy_metatable_name);
+
+    luaL_Reg metamethods[] = { { "__index", container_proxy_index },
+        { "__newindex", container_proxy_newindex },
+        { "__len", container_proxy_length },
+        { "__gc", destruct_container_proxy },
+        { nullptr, nullptr } };
+
+    lua_pushlightuserdata(lua, glua);
+    luaL_setfuncs(lua, metamethods, 1);
+
+    // pairs and ipairs both walk the container through the same iterator.
+    // Lua 5.4 only honours __pairs (ipairs goes through __index), LuaJIT
+    // honours both once GluaLua replaced pairs and ipairs
+    lua_pushlightuserdata(lua, glua);
+    lua_pushcclosure(lua, container_proxy_next, 1);
+
+    lua_pushvalue(lua, -1);
+    lua_pushcclosure(lua, container_proxy_pairs, 1);
+    lua_setfield(lua, -3, "__pairs");
+
+    lua_pushcclosure(lua, container_proxy_pairs, 1);
+    lua_setfield(lua, -2, "__ipairs");
+
+    lua_pop(lua, 1);
+}
+
+GluaLuaCommon::GluaLuaCommon(std::ostream& output_stream)
+    : m_lua(luaL_newstate(), LuaStateDeleter {})
+    , m_print_target(std::make_unique<PrintTarget>())
+    , m_metrics(std::make_unique<ScriptMetrics>())
+    , m_error_capture_enabled(false)
+    , m_error_details(std::make_unique<ScriptErrorDetails>())
+{
+    m_print_target->sink = std::make_shared<OStreamPrintSink>(output_stream);
+
+    luaL_openlibs(m_lua.get());
+
+    glua_create_container_proxy_metatable(m_lua.get(), this);
+
+    luaL_newmetatable(m_lua.get(), thunk_metatable_name);
+    lua_pushcfunction(m_lua.get(), destruct_thunk);
+    lua_setfield(m_lua.get(), -2, "__gc");
+    lua_pop(m_lua.get(), 1);
+
+    // created once so capturing errors doesn't create a closure per call
+    lua_pushlightuserdata(m_lua.get(), m_error_details.get());
+    lua_pushcclosure(m_lua.get(), capture_script_error, 1);
+    m_error_handler_ref = luaL_ref(m_lua.get(), LUA_REGISTRYINDEX);
+}
+auto GluaLuaCommon::setUpSandbox(const SandboxEnvironment& environment,
+    bool start_sandboxed) -> void
+{
+    luaL_Reg print_override_lib[] = { { "print", glua_capture_print },
+        { nullptr, nullptr } };
+
+    // create sandbox environment
+    lua_newtable(m_lua.get());
+
+    glua_set_environment_to_stack(m_lua.get(), environment.globals);
+
+    for (const auto& library : environment.libraries) {
+        glua_set_sub_environment_to_stack(m_lua.get(), library.first,
+            library.second);
+    }
+
+    lua_pushlightuserdata(m_lua.get(), m_print_target.get());
+    lua_getglobal(m_lua.get(), "tostring");
+    luaL_setfuncs(m_lua.get(), print_override_lib, 2);
+
+    lua_setglobal(m_lua.get(), "__libglua__sandbox__");
+
+    // now that sandbox is set up, reset environment
+    ResetEnvironment(start_sandboxed);
+
+    // put print override on the non-sandbox _G as well
+    lua_getglobal(m_lua.get(), "_G");
+    lua_pushlightuserdata(m_lua.get(), m_print_target.get());
+    lua_getglobal(m_lua.get(), "tostring");
+    luaL_setfuncs(m_lua.get(), print_override_lib, 2);
+    lua_pop(m_lua.get(), 1);
+}
+auto GluaLuaCommon::SetErrorCaptureEnabled(bool enabled) -> void
+{
+    m_error_capture_enabled = enabled;
+}
+auto GluaLuaCommon::IsErrorCaptureEnabled() const -> bool
+{
+    return m_error_capture_enabled;
+}
+auto GluaLuaCommon::SetPrintSink(std::shared_ptr<IPrintSink> sink) -> void
+{
+    if (sink == nullptr) {
+        throw exceptions::LuaException("Print sink must not be null");
+    }
+
+    m_print_target->sink->Flush();
+    m_print_target->sink = std::move(sink);
+}
+auto GluaLuaCommon::GetPrintSink() const -> const std::shared_ptr<IPrintSink>&
+{
+    return m_print_target->sink;
+}
+auto GluaLuaCommon::SetMetricsEnabled(bool enabled) -> void
+{
+    if (enabled) {
+        armGcCycleCounter();
+        m_metrics->SetMemoryBytes(getMemoryBytes());
+    }
+
+    m_metrics->SetEnabled(enabled);
+}
+auto GluaLuaCommon::GetMetrics() const -> const ScriptMetrics&
+{
+    return *m_metrics;
+}
+auto GluaLuaCommon::ResetEnvironment(bool sandboxed) -> void
+{
+    if (sandboxed) {
+        lua_getglobal(m_lua.get(), "__libglua__sandbox__");
+    } else {
+        lua_getglobal(m_lua.get(), "_G");
+    }
+
+    lua_newtable(m_lua.get()); // env
+    lua_pushvalue(m_lua.get(), -1); // env -> env
+    lua_pushliteral(m_lua.get(), "__index"); // env -> env -> __index
+    lua_pushvalue(m_lua.get(), -4); // push (__libglua__sandbox__ or _G), env ->
+        // env -> __index -> sandbox
+    lua_settable(m_lua.get(), -3); // env -> env
+    lua_setmetatable(m_lua.get(), -2); // env
+
+    lua_setglobal(m_lua.get(), "__libglua__env__");
+    lua_pop(m_lua.get(), 1); // pop (__libglua__sandbox__ or _G)
+}
+auto GluaLuaCommon::RegisterCallable(const std::string& name, Callable callable)
+    -> void
+{
+    if (m_ffi_function_names.count(name) > 0) {
+        throw exceptions::LuaException(
+            "Registered a callable with an already used name");
+    }
+
+    auto insert_pair = m_registry.emplace(std::string { name },
+        std::move(callable).AcquireCallable());
+
+    if (insert_pair.second) {
+        pushCallable(insert_pair.first->second.get(), name);
+
+        setRegisteredGlobalFromTopOfStack(name);
+    } else {
+        throw exceptions::LuaException(
+            "Registered a callable with an already used name");
+    }
+}
+auto GluaLuaCommon::pushCallable(ICallable* callable, std::string metrics_name)
+    -> void
+{
+    auto is_thunk = pushCallableUpvalue(callable);
+    lua_pushlightuserdata(m_lua.get(), m_metrics->AddCallable(std::move(metrics_name)));
+
+    if (is_thunk) {
+        lua_pushcclosure(m_lua.get(), call_thunk_from_lua, 2);
+    } else {
+        lua_pushcclosure(m_lua.get(), call_callable_from_lua, 2);
+    }
+}
+auto GluaLuaCommon::pushCallableUpvalue(ICallable* callable) -> bool
+{
+    auto* lua = m_lua.get();
+    auto* thunk_callable = dynamic_cast<IGluaThunkCallable*>(callable);
+
+    // userdata is only guaranteed the alignment of the header's members
+    if (thunk_callable != nullptr
+        && thunk_callable->GetThunk().functor_alignment <= alignof(ThunkHeader)) {
+        auto thunk = thunk_callable->GetThunk();
+        auto functor_offset = (sizeof(ThunkHeader) + thunk.functor_alignment - 1)
+            / thunk.functor_alignment * thunk.functor_alignment;
+
+        auto* storage = static_cast<char*>(
+            lua_compat::new_userdata(lua, functor_offset + thunk.functor_size));
+        thunk_callable->MoveFunctorTo(storage + functor_offset);
+        new (storage) ThunkHeader { thunk.call, this, thunk.destroy_functor,
+            functor_offset };
+
+        // the functor is destroyed with the userdata, the registered callable
+        // is left moved from and only reserves the name
+        luaL_getmetatable(lua, thunk_metatable_name);
+        lua_setmetatable(lua, -2);
+
+        return true;
+    }
+
+    lua_pushlightuserdata(lua, callable);
+
+    return false;
+}
+auto GluaLuaCommon::setRegisteredGlobalFromTopOfStack(const std::string& name)
+    -> void
+{
+    // set the value on the sandbox environment
+    lua_getglobal(m_lua.get(), "__libglua__sandbox__");
+    lua_pushlstring(m_lua.get(), name.data(), name.size());
+    lua_pushvalue(m_lua.get(), -3); // push value back on stack
+    lua_settable(m_lua.get(), -3);
+    lua_pop(m_lua.get(), 1);
+
+    // now the original value is all that's left on the stack, set to global
+    // env too
+    lua_setglobal(m_lua.get(), name.data());
+}
+auto GluaLuaCommon::push(std::nullopt_t /*unused*/) -> void
+{
+    lua_pushnil(m_lua.get());
+}
+auto GluaLuaCommon::push(bool value) -> void
+{
+    lua_pushboolean(m_lua.get(), value ? 1 : 0);
+}
+auto GluaLuaCommon::push(int8_t value) -> void
+{
+    lua_pushinteger(m_lua.get(), value);
+}
+auto GluaLuaCommon::push(int16_t value) -> void
+{
+    lua_pushinteger(m_lua.get(), value);
+}
+auto GluaLuaCommon::push(int32_t value) -> void
+{
+    lua_pushinteger(m_lua.get(), value);
+}
+auto GluaLuaCommon::push(uint8_t value) -> void
+{
+    lua_pushinteger(m_lua.get(), static_cast<lua_Integer>(value));
+}
+auto GluaLuaCommon::push(uint16_t value) -> void
+{
+    lua_pushinteger(m_lua.get(), static_cast<lua_Integer>(value));
+}
+auto GluaLuaCommon::push(uint32_t value) -> void
+{
+    lua_pushinteger(m_lua.get(), static_cast<lua_Integer>(value));
+}
+auto GluaLuaCommon::push(float value) -> void
+{
+    lua_pushnumber(m_lua.get(), static_cast<double>(value));
+}
+auto GluaLuaCommon::push(double value) -> void
+{
+    lua_pushnumber(m_lua.get(), value);
+}
+auto GluaLuaCommon::push(const char* value) -> void
+{
+    lua_pushstring(m_lua.get(), value);
+}
+auto GluaLuaCommon::push(std::string_view value) -> void
+{
+    lua_pushlstring(m_lua.get(), value.data(), value.size());
+}
+auto GluaLuaCommon::push(std::string value) -> void
+{
+    lua_pushlstring(m_lua.get(), value.data(), value.size());
+}
+auto GluaLuaCommon::pushArray(size_t size_hint) -> void
+{
+    lua_createtable(m_lua.get(), static_cast<int>(size_hint), 0);
+}
+auto GluaLuaCommon::pushStartMap(size_t size_hint) -> void
+{
+    lua_createtable(m_lua.get(), 0, static_cast<int>(size_hint));
+}
+auto GluaLuaCommon::arraySetFromStack() -> void
+{
+    // top of stack: value
+    // top -1: index
+    // top -2: table
+    lua_settable(m_lua.get(), -3);
+}
+auto GluaLuaCommon::mapSetFromStack() -> void
+{
+    // top of stack: value
+    // top -1: key
+    // top -2: table
+    lua_settable(m_lua.get(), -3);
+}
+auto GluaLuaCommon::pushUserType(const std::string& unique_type_name,
+    std::unique_ptr<IManagedTypeStorage> user_storage)
+    -> void
+{
+    auto** managed_type_ptr = static_cast<IManagedTypeStorage**>(
+        lua_compat::new_userdata(m_lua.get(), sizeof(IManagedTypeStorage*)));
+
+    *managed_type_ptr = user_storage.get();
+    user_storage.release();
+
+    // set the metatable for this object
+    luaL_getmetatable(m_lua.get(), unique_type_name.data());
+
+    if (lua_isnil(m_lua.get(), -1)) {
+        lua_pop(m_lua.get(), 1);
+
+        // reacquire the pointer as a unique pointer to delete it when leaving scope
+        std::unique_ptr<IManagedTypeStorage> reacquired_memory { *managed_type_ptr };
+
+        throw std::runtime_error(
+            "Pushing class type which has not been registered [null metatable]! " + unique_type_name);
+    }
+
+    lua_setmetatable(m_lua.get(), -2);
+
+    // copies have no identity and borrows must not outlive their release
+    auto storage_type = (*managed_type_ptr)->GetStorageType();
+
+    if (m_identity_cache_refs.empty()
+        || (storage_type != ManagedTypeStorageType::RAW_PTR
+            && storage_type != ManagedTypeStorageType::SHARED_PTR)) {
+        return;
+    }
+
+    auto cache_pos = m_identity_cache_refs.find(unique_type_name);
+
+    if (cache_pos != m_identity_cache_refs.end()) {
+        lua_rawgeti(m_lua.get(), LUA_REGISTRYINDEX, cache_pos->second);
+        lua_pushlightuserdata(m_lua.get(), (*managed_type_ptr)->GetStoredPointer());
+        lua_pushvalue(m_lua.get(), -3);
+        lua_rawset(m_lua.get(), -3);
+        lua_pop(m_lua.get(), 1);
+    }
+}
+auto GluaLuaCommon::pushCachedUserType(const std::string& unique_type_name,
+    const void* address, bool requires_ownership) -> bool
+{
+    if (m_identity_cache_refs.empty() || address == nullptr) {
+        return false;
+    }
+
+    auto cache_pos = m_identity_cache_refs.find(unique_type_name);
+
+    if (cache_pos == m_identity_cache_refs.end()) {
+        return false;
+    }
+
+    auto* lua = m_lua.get();
+
+    lua_rawgeti(lua, LUA_REGISTRYINDEX, cache_pos->second);
+    lua_pushlightuserdata(lua, const_cast<void*>(address));
+    lua_rawget(lua, -2);
+    lua_remove(lua, -2);
+
+    if (!lua_isnil(lua, -1)) {
+        auto** managed_type_ptr = static_cast<IManagedTypeStorage**>(lua_touserdata(lua, -1));
+
+        // a raw pointer doesn't keep the object alive for a shared_ptr push
+        if (!requires_ownership
+            || (*managed_type_ptr)->GetStorageType() == ManagedTypeStorageType::SHARED_PTR) {
+            return true;
+        }
+    }
+
+    lua_pop(lua, 1);
+
+    return false;
+}
+auto GluaLuaCommon::pushContainerProxy(std::unique_ptr<IContainerProxy> proxy)
+    -> void
+{
+    auto** proxy_ptr = static_cast<IContainerProxy**>(
+        lua_compat::new_userdata(m_lua.get(), sizeof(IContainerProxy*)));
+
+    *proxy_ptr = proxy.release();
+
+    luaL_getmetatable(m_lua.get(), container_proxy_metatable_name);
+    lua_setmetatable(m_lua.get(), -2);
+}
+auto GluaLuaCommon::getBool(int stack_index) const -> bool
+{
+    return static_cast<bool>(lua_toboolean(m_lua.get(), stack_index));
+}
+auto GluaLuaCommon::getInt8(int stack_index) const -> int8_t
+{
+    return static_cast<int8_t>(lua_tointeger(m_lua.get(), stack_index));
+}
+auto GluaLuaCommon::getInt16(int stack_index) const -> int16_t
+{
+    return static_cast<int16_t>(lua_tointeger(m_lua.get(), stack_index));
+}
+auto GluaLuaCommon::getInt32(int stack_index) const -> int32_t
+{
+    return static_cast<int32_t>(lua_tointeger(m_lua.get(), stack_index));
+}
+auto GluaLuaCommon::getUInt8(int stack_index) const -> uint8_t
+{
+    return static_cast<uint8_t>(lua_tointeger(m_lua.get(), stack_index));
+}
+auto GluaLuaCommon::getUInt16(int stack_index) const -> uint16_t
+{
+    return static_cast<uint16_t>(lua_tointeger(m_lua.get(), stack_index));
+}
+auto GluaLuaCommon::getUInt32(int stack_index) const -> uint32_t
+{
+    return static_cast<uint32_t>(lua_tointeger(m_lua.get(), stack_index));
+}
+auto GluaLuaCommon::getFloat(int stack_index) const -> float
+{
+    return static_cast<float>(lua_tonumber(m_lua.get(), stack_index));
+}
+auto GluaLuaCommon::getDouble(int stack_index) const -> double
+{
+    return static_cast<double>(lua_tonumber(m_lua.get(), stack_index));
+}
+auto GluaLuaCommon::getCharPointer(int stack_index) const -> const char*
+{
+    return lua_tostring(m_lua.get(), stack_index);
+}
+auto GluaLuaCommon::tryGetNumber(int stack_index) const -> std::optional<double>
+{
+    int is_number = 0;
+    auto number = lua_tonumberx(m_lua.get(), stack_index, &is_number);
+
+    if (is_number == 0) {
+        return std::nullopt;
+    }
+
+    return static_cast<double>(number);
+}
+auto GluaLuaCommon::tryGetStringView(int stack_index) const
+    -> std::optional<std::string_view>
+{
+    size_t length = 0;
+    const auto* c_str = lua_tolstring(m_lua.get(), stack_index, &length);
+
+    if (c_str == nullptr) {
+        return std::nullopt;
+    }
+
+    return std::string_view { c_str, length };
+}
+auto GluaLuaCommon::getStringView(int stack_index) const -> std::string_view
+{
+    size_t length;
+    const auto* c_str = lua_tolstring(m_lua.get(), stack_index, &length);
+
+    std::string_view ret_val { c_str, length };
+
+    return ret_val;
+}
+auto GluaLuaCommon::getString(int stack_index) const -> std::string
+{
+    size_t length;
+    const auto* c_str = lua_tolstring(m_lua.get(), stack_index, &length);
+
+    std::string ret_val { c_str, length };
+
+    return ret_val;
+}
+auto GluaLuaCommon::getArraySize(int stack_index) const -> size_t
+{
+    if (lua_istable(m_lua.get(), stack_index)) {
+        return lua_compat::raw_length(m_lua.get(), stack_index);
+    }
+
+    throw exceptions::LuaException("GetArraySize for non-table value");
+}
+auto GluaLuaCommon::getArrayValue(size_t index_into_array,
+    int stack_index_of_array) const -> void
+{
+    // raw, an __index metamethod could raise a Lua error over C++ frames
+    if (!lua_istable(m_lua.get(), stack_index_of_array)) {
+        throw exceptions::LuaException("GetArrayValue for non-table value");
+    }
+
+    lua_compat::raw_get_index(m_lua.get(), stack_index_of_array, index_into_array);
+}
+auto GluaLuaCommon::getMapKeys(int stack_index) const -> std::vector<std::string>
+{
+    auto absolute_map_index = lua_compat::absolute_index(m_lua.get(), stack_index);
+    if (lua_istable(m_lua.get(), stack_index)) {
+        auto size = lua_compat::raw_length(m_lua.get(), stack_index);
+
+        std::vector<std::string> result;
+        result.reserve(size);
+
+        // push first nil key to start iteration
+        lua_pushnil(m_lua.get());
+        while (lua_next(m_lua.get(), absolute_map_index) != 0) {
+            // key then value were pushed onto stack
+            lua_pop(m_lua.get(), 1); // pop off value, we're not looking
+
+            if (lua_type(m_lua.get(), -1) == LUA_TSTRING) {
+                size_t str_len = 0;
+                const char* str = lua_tolstring(m_lua.get(), -1, &str_len);
+                result.emplace_back(str, str_len);
+            } else {
+                // key isn't string, lua_tolstring will convert it to a string and mess
+                // up iteration, create copy
+                lua_pushvalue(m_lua.get(), -1);
+
+                size_t str_len = 0;
+                const char* str = lua_tolstring(m_lua.get(), -1, &str_len);
+                result.emplace_back(str, str_len);
+
+                // now pop off copy
+                lua_pop(m_lua.get(), 1);
+            }
+        }
+
+        return result;
+    }
+
+    throw exceptions::LuaException("GetMapKeys for non-table value");
+}
+auto GluaLuaCommon::getMapValue(std::string_view key,
+    int stack_index_of_map) const -> void
+{
+    // raw, an __index metamethod could raise a Lua error over C++ frames
+    if (!lua_istable(m_lua.get(), stack_index_of_map)) {
+        throw exceptions::LuaException("GetMapValue for non-table value");
+    }
+
+    auto absolute_map_index = lua_compat::absolute_index(m_lua.get(), stack_index_of_map);
+    lua_pushlstring(m_lua.get(), key.data(), key.size());
+    lua_rawget(m_lua.get(), absolute_map_index);
+}
+auto GluaLuaCommon::nextMapEntry(int stack_index_of_map) const -> bool
+{
+    // previous key is on top of the stack, replaced by the next key and value
+    return lua_next(m_lua.get(),
+               lua_compat::absolute_index(m_lua.get(), stack_index_of_map))
+        != 0;
+}
+auto GluaLuaCommon::pushValueCopy(int stack_index) -> void
+{
+    lua_pushvalue(m_lua.get(), stack_index);
+}
+auto GluaLuaCommon::internKey(std::string_view key) -> int
+{
+    // keep the string alive in the registry so it can be pushed by reference
+    // instead of being hashed and interned again on every push
+    lua_pushlstring(m_lua.get(), key.data(), key.size());
+    return luaL_ref(m_lua.get(), LUA_REGISTRYINDEX);
+}
+auto GluaLuaCommon::pushInternedKey(int key_ref) -> void
+{
+    lua_rawgeti(m_lua.get(), LUA_REGISTRYINDEX, key_ref);
+}
+auto GluaLuaCommon::getInternedMapValue(int key_ref,
+    int stack_index_of_map) const -> void
+{
+    auto absolute_map_index = lua_compat::absolute_index(m_lua.get(), stack_index_of_map);
+    lua_rawgeti(m_lua.get(), LUA_REGISTRYINDEX, key_ref);
+    lua_rawget(m_lua.get(), absolute_map_index);
+}
+auto GluaLuaCommon::walkTablePath(const TablePathSegment* segments,
+    size_t segment_count) -> void
+{
+    auto* state = m_lua.get();
+
+    for (size_t i = 0; i < segment_count; ++i) {
+        if (!lua_istable(state, -1)) {
+            // like a missing child, anything below a non-table is nil
+            lua_pop(state, 1);
+            lua_pushnil(state);
+            return;
+        }
+
+        if (segments[i].is_index) {
+            lua_compat::raw_get_index(state, -1, segments[i].index);
+        } else {
+            lua_rawgeti(state, LUA_REGISTRYINDEX, segments[i].key_ref);
+            lua_rawget(state, -2);
+        }
+
+        lua_replace(state, -2); // the child takes its parent's place
+    }
+}
+auto GluaLuaCommon::getUserType(const std::string& unique_type_name,
+    int stack_index) const -> IManagedTypeStorage*
+{
+    auto** managed_type_ptr = static_cast<IManagedTypeStorage**>(
+        luaL_testudata(m_lua.get(), stack_index, unique_type_name.data()));
+
+    if (managed_type_ptr == nullptr) {
+        if (isDerivedUserType(unique_type_name, stack_index)) {
+            managed_type_ptr = static_cast<IManagedTypeStorage**>(
+                lua_touserdata(m_lua.get(), stack_index));
+        } else {
+            throw exceptions::GluaTypeException(unique_type_name + " expected, got "
+                + luaL_typename(m_lua.get(), stack_index));
+        }
+    }
+
+    // a released borrow must not reach its (possibly destroyed) object
+    if (!(*managed_type_ptr)->IsValid()) {
+        throw exceptions::LuaException(
+            "attempt to use a released borrowed " + unique_type_name);
+    }
+
+    return *managed_type_ptr;
+}
+auto GluaLuaCommon::isUserType(const std::string& unique_type_name,
+    int stack_index) const -> bool
+{
+    return luaL_testudata(m_lua.get(), stack_index, unique_type_name.data()) != nullptr
+        || isDerivedUserType(unique_type_name, stack_index);
+}
+auto GluaLuaCommon::getContainerProxy(int stack_index) const -> IContainerProxy*
+{
+    auto** proxy_ptr = static_cast<IContainerProxy**>(
+        luaL_testudata(m_lua.get(), stack_index, container_proxy_metatable_name));
+
+    return proxy_ptr != nullptr ? *proxy_ptr : nullptr;
+}
+auto GluaLuaCommon::getValueType(int stack_index) const -> GluaValueType
+{
+    switch (lua_type(m_lua.get(), stack_index)) {
+    case LUA_TNONE:
+    case LUA_TNIL:
+        return GluaValueType::NIL;
+    case LUA_TBOOLEAN:
+        return GluaValueType::BOOLEAN;
+    case LUA_TNUMBER:
+        return GluaValueType::NUMBER;
+    case LUA_TSTRING:
+        return GluaValueType::STRING;
+    case LUA_TTABLE:
+        return GluaValueType::TABLE;
+    case LUA_TUSERDATA:
+    case LUA_TLIGHTUSERDATA:
+        return GluaValueType::USERDATA;
+    case LUA_TFUNCTION:
+        return GluaValueType::FUNCTION;
+    default:
+        return GluaValueType::OTHER;
+    }
+}
+auto GluaLuaCommon::isNull(int stack_index) const -> bool
+{
+    // arguments left out of a call are none, which reads like nil
+    return lua_isnoneornil(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isBool(int stack_index) const -> bool
+{
+    return lua_isboolean(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isInt8(int stack_index) const -> bool
+{
+    return lua_isnumber(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isInt16(int stack_index) const -> bool
+{
+    return lua_isnumber(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isInt32(int stack_index) const -> bool
+{
+    return lua_isnumber(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isUInt8(int stack_index) const -> bool
+{
+    return lua_isnumber(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isUInt16(int stack_index) const -> bool
+{
+    return lua_isnumber(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isUInt32(int stack_index) const -> bool
+{
+    return lua_isnumber(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isFloat(int stack_index) const -> bool
+{
+    return lua_isnumber(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isDouble(int stack_index) const -> bool
+{
+    return lua_isnumber(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isCharPointer(int stack_index) const -> bool
+{
+    return lua_isstring(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isStringView(int stack_index) const -> bool
+{
+    return lua_isstring(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isString(int stack_index) const -> bool
+{
+    return lua_isstring(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isArray(int stack_index) const -> bool
+{
+    return lua_istable(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::isMap(int stack_index) const -> bool
+{
+    return lua_istable(m_lua.get(), stack_index) != 0;
+}
+auto GluaLuaCommon::setGlobalFromStack(const std::string& name,
+    int stack_index) -> void
+{
+    auto absolute_value_index = lua_compat::absolute_index(m_lua.get(), stack_index);
+    lua_getglobal(m_lua.get(), "__libglua__env__");
+    lua_pushlstring(m_lua.get(), name.data(), name.size());
+    lua_pushvalue(
+        m_lua.get(),
+        absolute_value_index); // get value from original stack back into position
+
+    lua_settable(m_lua.get(), -3);
+
+    lua_pop(m_lua.get(), 1); // env table is still on stack, pop
+}
+auto GluaLuaCommon::pushGlobal(const std::string& name) -> void
+{
+    pushValueOfGlobalOntoStack(name);
+}
+auto GluaLuaCommon::popOffStack(size_t count) -> void
+{
+    lua_pop(m_lua.get(), static_cast<int>(count));
+}
+auto GluaLuaCommon::removeFromStack(int stack_index) -> void
+{
+    lua_remove(m_lua.get(), stack_index);
+}
+auto GluaLuaCommon::getStackTop() -> int { return lua_gettop(m_lua.get()); }
+auto GluaLuaCommon::setStackTop(int stack_top) -> void
+{
+    lua_settop(m_lua.get(), stack_top);
+}
+auto GluaLuaCommon::callScriptFunctionImpl(const std::string& function_name,
+    size_t arg_count) -> void
+{
+    pushValueOfGlobalOntoStack(function_name);
+
+    if (!lua_isfunction(m_lua.get(), -1)) {
+        throw exceptions::LuaException("Attempted to call lua script function " + function_name + " which was not a function");
+    }
+
+    // arg_count arguments were already on the stack, but lua requires the
+    // function before the arguments
+    if (arg_count > 0) {
+        // need to move the function back arg_count layers on the stack
+        lua_insert(m_lua.get(), -1 - static_cast<int>(arg_count));
+    }
+
+    setEnvironmentOfFunction(-1 - static_cast<int>(arg_count));
+
+    if (script_tracer::is_enabled() || m_metrics->IsEnabled()) {
+        observedProtectedCall(function_name, static_cast<int>(arg_count));
+
+        return;
+    }
+
+    protectedCall(function_name, static_cast<int>(arg_count));
+}
+auto GluaLuaCommon::registerClassImpl(
+    const std::string& class_name,
+    std::unordered_map<std::string, std::unique_ptr<ICallable>>
+        method_callables) -> void
+{
+    luaL_newmetatable(m_lua.get(), class_name.data());
+
+    lua_pushstring(m_lua.get(), "__gc");
+    lua_pushcfunction(m_lua.get(), &destruct_managed_type);
+    lua_settable(m_lua.get(), -3);
+
+    auto pos_pair = m_method_registry.emplace(class_name, std::move(method_callables));
+    auto& our_registry = pos_pair.first->second;
+
+    lua_pushstring(m_lua.get(), "__index");
+    lua_pushvalue(m_lua.get(), -2);
+    lua_settable(m_lua.get(), -3);
+
+    for (auto& method_pair : our_registry) {
+        lua_pushstring(m_lua.get(), method_pair.first.data());
+        pushCallable(method_pair.second.get(), class_name + ":" + method_pair.first);
+
+        lua_settable(m_lua.get(), -3);
+    }
+
+    // pop the new metatable off the stack
+    lua_pop(m_lua.get(), 1);
+}
+auto GluaLuaCommon::registerMethodImpl(const std::string& class_name,
+    const std::string& method_name,
+    Callable method) -> void
+{
+    luaL_getmetatable(m_lua.get(), class_name.data());
+
+    auto pos_pair = m_method_registry[class_name].emplace(
+        method_name, std::move(method).AcquireCallable());
+
+    if (pos_pair.second) {
+        lua_pushlstring(m_lua.get(), method_name.data(), method_name.size());
+        pushCallable(pos_pair.first->second.get(), class_name + ":" + method_name);
+    } else {
+        lua_pop(m_lua.get(), 1);
+
+        throw exceptions::LuaException(
+            "Tried to register method with already registered name [" + method_name + "]");
+    }
+
+    lua_settable(m_lua.get(), -3);
+    lua_pop(m_lua.get(), 1); // pop the metatable
+}
+auto GluaLuaCommon::setIdentityCacheEnabledImpl(const std::string& class_name,
+    bool enabled) -> void
+{
+    auto* lua = m_lua.get();
+    auto cache_pos = m_identity_cache_refs.find(class_name);
+
+    if (enabled && cache_pos == m_identity_cache_refs.end()) {
+        // weak valued, userdata only stay cached while the script references them
+        lua_newtable(lua);
+        lua_newtable(lua);
+        lua_pushstring(lua, "v");
+        lua_setfield(lua, -2, "__mode");
+        lua_setmetatable(lua, -2);
+
+        m_identity_cache_refs.emplace(class_name, luaL_ref(lua, LUA_REGISTRYINDEX));
+    } else if (!enabled && cache_pos != m_identity_cache_refs.end()) {
+        luaL_unref(lua, LUA_REGISTRYINDEX, cache_pos->second);
+        m_identity_cache_refs.erase(cache_pos);
+    }
+}
+auto GluaLuaCommon::registerPropertyImpl(const std::string& class_name,
+    const std::string& property_name, Callable getter,
+    std::optional<Callable> setter) -> void
+{
+    auto* lua = m_lua.get();
+
+    pushPropertyTables(class_name);
+
+    lua_pushlstring(lua, property_name.data(), property_name.size());
+    lua_rawget(lua, -3);
+    auto is_registered = !lua_isnil(lua, -1);
+    lua_pop(lua, 1);
+
+    if (is_registered) {
+        lua_pop(lua, 2);
+        throw exceptions::LuaException(
+            "Tried to register property with already registered name [" + property_name + "]");
+    }
+
+    m_property_callables.emplace_back(std::move(getter).AcquireCallable());
+    pushCallableUpvalue(m_property_callables.back().get());
+    lua_setfield(lua, -3, property_name.data());
+
+    if (setter.has_value()) {
+        m_property_callables.emplace_back(std::move(setter.value()).AcquireCallable());
+        pushCallableUpvalue(m_property_callables.back().get());
+        lua_setfield(lua, -2, property_name.data());
+    }
+
+    lua_pop(lua, 2);
+}
+auto GluaLuaCommon::pushPropertyTables(const std::string& class_name) -> void
+{
+    auto* lua = m_lua.get();
+
+    luaL_getmetatable(lua, class_name.data());
+    auto metatable_index = lua_gettop(lua);
+
+    // raw, a derived metatable would find its base's tables
+    lua_pushliteral(lua, "__getters");
+    lua_rawget(lua, metatable_index);
+
+    if (lua_isnil(lua, -1)) {
+        lua_pop(lua, 1);
+
+        // the first property swaps __index = metatable for closures looking
+        // up getters and setters before falling back to the methods
+        lua_newtable(lua);
+        lua_pushvalue(lua, -1);
+        lua_setfield(lua, metatable_index, "__getters");
+
+        lua_newtable(lua);
+        lua_pushvalue(lua, -1);
+        lua_setfield(lua, metatable_index, "__setters");
+
+        lua_pushvalue(lua, metatable_index);
+        lua_pushvalue(lua, -3);
+        lua_pushcclosure(lua, class_property_index, 2);
+        lua_setfield(lua, metatable_index, "__index");
+
+        lua_pushvalue(lua, -1);
+        lua_pushcclosure(lua, class_property_newindex, 1);
+        lua_setfield(lua, metatable_index, "__newindex");
+    } else {
+        lua_pushliteral(lua, "__setters");
+        lua_rawget(lua, metatable_index);
+    }
+
+    // leave only the getters and setters tables
+    lua_remove(lua, metatable_index);
+}
+auto GluaLuaCommon::registerBaseClassImpl(const std::string& class_name,
+    const std::string& base_class_name) -> void
+{
+    auto* lua = m_lua.get();
+
+    // instances of the class look properties and methods up through the
+    // generated __index, which falls back to the base's tables
+    pushPropertyTables(class_name);
+    pushPropertyTables(base_class_name);
+    luaL_getmetatable(lua, class_name.data());
+    luaL_getmetatable(lua, base_class_name.data());
+
+    // stack is (getters, setters, base getters, base setters, metatable,
+    // base metatable)
+    auto top = lua_gettop(lua);
+
+    setIndexFallback(top - 5, top - 3);
+    setIndexFallback(top - 4, top - 2);
+    setIndexFallback(top - 1, top);
+
+    lua_pop(lua, 6);
+}
+auto GluaLuaCommon::registerAncestorClassImpl(const std::string& class_name,
+    const std::string& ancestor_class_name) -> void
+{
+    auto* lua = m_lua.get();
+
+    luaL_getmetatable(lua, class_name.data());
+
+    lua_pushstring(lua, ancestors_field_name);
+    lua_rawget(lua, -2);
+
+    if (lua_isnil(lua, -1)) {
+        lua_pop(lua, 1);
+
+        lua_newtable(lua);
+        lua_pushstring(lua, ancestors_field_name);
+        lua_pushvalue(lua, -2);
+        lua_rawset(lua, -4);
+    }
+
+    lua_pushlstring(lua, ancestor_class_name.data(), ancestor_class_name.size());
+    lua_pushboolean(lua, 1);
+    lua_rawset(lua, -3);
+
+    lua_pop(lua, 2);
+}
+auto GluaLuaCommon::setIndexFallback(int table_index, int fallback_index)
+    -> void
+{
+    auto* lua = m_lua.get();
+
+    lua_newtable(lua);
+    lua_pushvalue(lua, fallback_index);
+    lua_setfield(lua, -2, "__index");
+    lua_setmetatable(lua, table_index);
+}
+auto GluaLuaCommon::isDerivedUserType(const std::string& unique_type_name,
+    int stack_index) const -> bool
+{
+    auto* lua = m_lua.get();
+
+    if (lua_type(lua, stack_index) != LUA_TUSERDATA
+        || lua_getmetatable(lua, stack_index) == 0) {
+        return false;
+    }
+
+    // registered derived classes list every ancestor in their metatable
+    lua_pushstring(lua, ancestors_field_name);
+    lua_rawget(lua, -2);
+
+    auto is_derived = false;
+
+    if (lua_istable(lua, -1)) {
+        lua_pushlstring(lua, unique_type_name.data(), unique_type_name.size());
+        lua_rawget(lua, -2);
+        is_derived = lua_toboolean(lua, -1) != 0;
+        lua_pop(lua, 1);
+    }
+
+    lua_pop(lua, 2);
+
+    return is_derived;
+}
+auto GluaLuaCommon::transformObjectIndex(size_t index) -> size_t
+{
+    return index + 1; // lua is one based
+}
+auto GluaLuaCommon::transformFunctionParameterIndex(size_t index) -> size_t
+{
+    return index + 1; // function parameter indices start at 1
+}
+auto GluaLuaCommon::runScript(std::string_view script_data) -> void
+{
+    auto code = luaL_loadbuffer(m_lua.get(), script_data.data(),
+        script_data.size(), "libglua");
+
+    if (code == 0) {
+        setEnvironmentOfFunction(-1);
+
+        if (script_tracer::is_enabled()) {
+            script_tracer::Span span { "RunScript" };
+            protectedCall("", 0);
+
+            return;
+        }
+
+        protectedCall("", 0);
+    } else {
+        throw exceptions::LuaException(std::string { "Failed to load script" }.append(
+            lua_tostring(m_lua.get(), -1)));
+    }
+}
+auto GluaLuaCommon::pushValueOfGlobalOntoStack(const std::string& global_name)
+    -> void
+{
+    lua_getglobal(m_lua.get(), "__libglua__env__");
+    lua_pushlstring(m_lua.get(), global_name.data(), global_name.size());
+
+    lua_gettable(m_lua.get(), -2);
+
+    lua_remove(m_lua.get(), -2); // remove sandbox env from stack
+}
+
+auto GluaLuaCommon::protectedCall(const std::string& function_name,
+    int arg_count) -> void
+{
+    // an error skips the end_span calls of the spans the script opened
+    std::optional<size_t> span_depth;
+
+    if (script_tracer::is_enabled()) {
+        span_depth = script_tracer::open_span_depth();
+    }
+
+    // the function and its arg_count arguments are on top of the stack
+    if (!m_error_capture_enabled) {
+        if (lua_pcall(m_lua.get(), arg_count, LUA_MULTRET, 0) != 0) {
+            if (span_depth.has_value()) {
+                script_tracer::end_spans_above(span_depth.value());
+            }
+
+            throwScriptError(function_name);
+        }
+
+        return;
+    }
+
+    // the error handler goes below the function, and stays below its results
+    auto handler_index = lua_gettop(m_lua.get()) - arg_count;
+    lua_rawgeti(m_lua.get(), LUA_REGISTRYINDEX, m_error_handler_ref);
+    lua_insert(m_lua.get(), handler_index);
+
+    auto code = lua_pcall(m_lua.get(), arg_count, LUA_MULTRET, handler_index);
+    lua_remove(m_lua.get(), handler_index);
+
+    if (code != 0) {
+        if (span_depth.has_value()) {
+            script_tracer::end_spans_above(span_depth.value());
+        }
+
+        throwScriptError(function_name);
+    }
+}
+auto GluaLuaCommon::observedProtectedCall(const std::string& function_name,
+    int arg_count) -> void
+{
+    std::optional<script_tracer::Span> span;
+
+    if (script_tracer::is_enabled()) {
+        span.emplace(function_name);
+    }
+
+    if (!m_metrics->IsEnabled()) {
+        protectedCall(function_name, arg_count);
+
+        return;
+    }
+
+    m_metrics->GetScriptFunctionStats(function_name).Measure([&]() {
+        protectedCall(function_name, arg_count);
+    });
+
+    m_metrics->SetMemoryBytes(getMemoryBytes());
+}
+auto GluaLuaCommon::getMemoryBytes() const -> uint64_t
+{
+    return static_cast<uint64_t>(lua_gc(m_lua.get(), LUA_GCCOUNT, 0)) * 1024
+        + static_cast<uint64_t>(lua_gc(m_lua.get(), LUA_GCCOUNTB, 0));
+}
+auto GluaLuaCommon::armGcCycleCounter() -> void
+{
+    auto* lua = m_lua.get();
+
+    if (luaL_newmetatable(lua, gc_sentinel_metatable_name) == 0) {
+        lua_pop(lua, 1);
+
+        return; // armed when metrics were first enabled
+    }
+
+    // the counter is kept alive by the finalizer closure, so it lives as long
+    // as the state
+    auto* counter = new (lua_compat::new_userdata(lua, sizeof(std::atomic<uint64_t>)))
+        std::atomic<uint64_t> { 0 };
+
+    lua_pushcclosure(lua, count_gc_cycle, 1);
+    lua_setfield(lua, -2, "__gc");
+    lua_pop(lua, 1);
+
+    push_gc_sentinel(lua);
+    lua_pop(lua, 1);
+
+    m_metrics->SetGcCycleCounter(counter);
+}
+auto GluaLuaCommon::throwScriptError(const std::string& function_name) -> void
+{
+    // copied so the exception doesn't depend on the state, the full message
+    // is only formatted when it's read
+    auto error_message = LuaScriptError::ErrorValueToString(m_lua.get(), -1);
+    lua_pop(m_lua.get(), 1);
+
+    auto details = std::move(*m_error_details);
+    *m_error_details = ScriptErrorDetails {};
+
+    throw LuaScriptError(function_name, std::move(error_message), std::move(details));
+}
+
+static auto call_callable(lua_State* state, ICallable* callable_ptr) -> int
+{
+    auto previous_top = lua_gettop(state);
+
+    callable_ptr->Call();
+
+    // tuple returns push one value per element, everything pushed is returned
+    return lua_gettop(state) - previous_top;
+}
+
+// traces and measures a call of a registered callable, whichever is enabled,
+// the second upvalue of its closure is its metrics slot
+template <typename Call>
+static auto observe_callable_call(CallableMetricsSlot* slot, Call&& call) -> int
+{
+    std::optional<script_tracer::Span> span;
+
+    if (script_tracer::is_enabled()) {
+        span.emplace(slot->GetName());
+    }
+
+    if (slot->IsEnabled()) {
+        return slot->GetStats().Measure(std::forward<Call>(call));
+    }
+
+    return call();
+}
+
+auto call_callable_from_lua(lua_State* state) -> int
+{
+    auto* callable_ptr = static_cast<ICallable*>(lua_touserdata(state, lua_upvalueindex(1)));
+    auto* slot = static_cast<CallableMetricsSlot*>(lua_touserdata(state, lua_upvalueindex(2)));
+
+    return call_protected(state, [state, callable_ptr, slot]() {
+        if (script_tracer::is_enabled() || slot->IsEnabled()) {
+            return observe_callable_call(slot,
+                [state, callable_ptr]() { return call_callable(state, callable_ptr); });
+        }
+
+        return call_callable(state, callable_ptr);
+    });
+}
+
+auto call_thunk_from_lua(lua_State* state) -> int
+{
+    auto* header = static_cast<ThunkHeader*>(lua_touserdata(state, lua_upvalueindex(1)));
+    auto* functor = reinterpret_cast<char*>(header) + header->functor_offset;
+    auto* slot = static_cast<CallableMetricsSlot*>(lua_touserdata(state, lua_upvalueindex(2)));
+
+    return call_protected(state, [header, functor, slot]() {
+        if (script_tracer::is_enabled() || slot->IsEnabled()) {
+            return observe_callable_call(slot,
+                [header, functor]() { return header->call(header->glua, functor); });
+        }
+
+        return header->call(header->glua, functor);
+    });
+}
+
+// calls the callable upvalue at stack_index, as pushed by pushCallableUpvalue,
+// with the arguments below it
+static auto call_callable_upvalue(lua_State* state, int stack_index) -> int
+{
+    if (lua_type(state, stack_index) == LUA_TUSERDATA) {
+        auto* header = static_cast<ThunkHeader*>(lua_touserdata(state, stack_index));
+
+        return header->call(header->glua,
+            reinterpret_cast<char*>(header) + header->functor_offset);
+    }
+
+    auto* callable_ptr = static_cast<ICallable*>(lua_touserdata(state, stack_index));
+
+    auto previous_top = lua_gettop(state);
+
+    callable_ptr->Call();
+
+    return lua_gettop(state) - previous_top;
+}
+
+auto class_property_index(lua_State* state) -> int
+{
+    // stack is (object, key), upvalues are (metatable, getters), both fall
+    // back to their base class's when registered with one
+    lua_pushvalue(state, 2);
+    lua_gettable(state, lua_upvalueindex(2));
+
+    if (!lua_isnil(state, -1)) {
+        // the getter takes the object at index 1 and pushes the value
+        lua_replace(state, 2);
+
+        return call_protected(state,
+            [state]() { return call_callable_upvalue(state, 2); });
+    }
+
+    lua_pop(state, 1);
+    lua_gettable(state, lua_upvalueindex(1));
+
+    return 1;
+}
+
+auto class_property_newindex(lua_State* state) -> int
+{
+    // stack is (object, key, value), the upvalue is the setters table
+    lua_pushvalue(state, 2);
+    lua_gettable(state, lua_upvalueindex(1));
+
+    return call_protected(state, [state]() {
+        if (lua_isnil(state, -1)) {
+            throw exceptions::LuaException(
+                std::string("assigned unknown or read only property '")
+                + (lua_type(state, 2) == LUA_TSTRING ? lua_tostring(state, 2) : "?")
+                + "'");
+        }
+
+        // the setter takes (object, value)
+        lua_remove(state, 2);
+        call_callable_upvalue(state, 3);
+
+        return 0;
+    });
+}
+
+auto destruct_thunk(lua_State* state) -> int
+{
+    auto* header = static_cast<ThunkHeader*>(lua_touserdata(state, 1));
+
+    header->destroy_functor(reinterpret_cast<char*>(header) + header->functor_offset);
+
+    return 0;
+}
+
+auto destruct_managed_type(lua_State* state) -> int
+{
+    auto** managed_type_ptr = static_cast<IManagedTypeStorage**>(lua_touserdata(state, 1));
+
+    std::unique_ptr<IManagedTypeStorage> reacquired_memory { *managed_type_ptr };
+
+    return 0;
+}
+
+static auto container_proxy_from_stack(lua_State* state) -> IContainerProxy*
+{
+    return *static_cast<IContainerProxy**>(lua_touserdata(state, 1));
+}
+
+static auto glua_from_upvalue(lua_State* state) -> GluaBase*
+{
+    return static_cast<GluaLuaCommon*>(lua_touserdata(state, lua_upvalueindex(1)));
+}
+
+auto container_proxy_index(lua_State* state) -> int
+{
+    return call_protected(state, [state]() {
+        container_proxy_from_stack(state)->Index(glua_from_upvalue(state), 2);
+
+        return 1;
+    });
+}
+
+auto container_proxy_newindex(lua_State* state) -> int
+{
+    return call_protected(state, [state]() {
+        container_proxy_from_stack(state)->NewIndex(glua_from_upvalue(state), 2, 3);
+
+        return 0;
+    });
+}
+
+auto container_proxy_length(lua_State* state) -> int
+{
+    return call_protected(state, [state]() {
+        lua_pushinteger(state,
+            static_cast<lua_Integer>(container_proxy_from_stack(state)->Length()));
+
+        return 1;
+    });
+}
+
+auto container_proxy_next(lua_State* state) -> int
+{
+    lua_settop(state, 2); // a missing key starts from the beginning
+
+    return call_protected(state, [state]() {
+        if (container_proxy_from_stack(state)->Next(glua_from_upvalue(state), 2)) {
+            return 2;
+        }
+
+        lua_pushnil(state);
+
+        return 1;
+    });
+}
+
+auto container_proxy_pairs(lua_State* state) -> int
+{
+    lua_pushvalue(state, lua_upvalueindex(1)); // iterator
+    lua_pushvalue(state, 1); // proxy
+    lua_pushnil(state); // initial key
+
+    return 3;
+}
+
+auto capture_script_error(lua_State* state) -> int
+{
+    auto* details = static_cast<ScriptErrorDetails*>(lua_touserdata(state, lua_upvalueindex(1)));
+
+    // the error is raised by the innermost Lua function, skip C functions
+    // like error() itself
+    lua_Debug debug {};
+    for (int level = 1; lua_getstack(state, level, &debug) != 0; ++level) {
+        lua_getinfo(state, "Sl", &debug);
+
+        if (debug.currentline > 0) {
+            break;
+        }
+    }
+
+    luaL_traceback(state, state, nullptr, 1);
+
+    return call_protected(state, [state, details, &debug]() {
+        if (debug.currentline > 0) {
+            details->chunk = debug.short_src;
+            details->line = debug.currentline;
+        }
+
+        details->traceback = lua_tostring(state, -1);
+        lua_pop(state, 1);
+
+        return 1; // the original error value
+    });
+}
+
+auto destruct_container_proxy(lua_State* state) -> int
+{
+    std::unique_ptr<IContainerProxy> reacquired_memory { container_proxy_from_stack(state) };
+
+    return 0;
+}
+
+} // namespace kdk::glua
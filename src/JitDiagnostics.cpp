@@ -0,0 +1,104 @@
+#include "glua/JitDiagnostics.h"
+
+namespace kdk::glua {
+auto JitOptions::ToArguments() const -> std::vector<std::string>
+{
+    std::vector<std::string> arguments;
+
+    if (optimization_level.has_value()) {
+        arguments.push_back(std::to_string(optimization_level.value()));
+    }
+
+    auto add_parameter = [&arguments](const char* name,
+                             const std::optional<int>& value) {
+        if (value.has_value()) {
+            arguments.push_back(std::string { name } + "=" + std::to_string(value.value()));
+        }
+    };
+
+    add_parameter("maxtrace", maxtrace);
+    add_parameter("maxrecord", maxrecord);
+    add_parameter("maxirconst", maxirconst);
+    add_parameter("maxside", maxside);
+    add_parameter("maxsnap", maxsnap);
+    add_parameter("hotloop", hotloop);
+    add_parameter("hotexit", hotexit);
+    add_parameter("tryside", tryside);
+    add_parameter("instunroll", instunroll);
+    add_parameter("loopunroll", loopunroll);
+    add_parameter("callunroll", callunroll);
+    add_parameter("recunroll", recunroll);
+    add_parameter("sizemcode", sizemcode);
+    add_parameter("maxmcode", maxmcode);
+
+    arguments.insert(arguments.end(), flags.begin(), flags.end());
+
+    return arguments;
+}
+
+JitTraceReport::JitTraceReport(size_t event_capacity)
+    : m_next_event(0)
+    , m_event_capacity(event_capacity)
+    , m_counts {}
+{
+}
+
+auto JitTraceReport::AddEvent(JitTraceEvent event) -> void
+{
+    ++m_counts[static_cast<size_t>(event.type)];
+
+    // aggregated now, so they cover events the ring no longer holds
+    if (event.type == JitTraceEventType::ABORT) {
+        ++m_aborts_by_location[event.source + ":" + std::to_string(event.line)];
+        ++m_aborts_by_reason[event.abort_reason];
+    }
+
+    if (m_event_capacity == 0) {
+        return;
+    }
+
+    if (m_events.size() < m_event_capacity) {
+        m_events.push_back(std::move(event));
+    } else {
+        m_events[m_next_event] = std::move(event);
+    }
+
+    m_next_event = (m_next_event + 1) % m_event_capacity;
+}
+auto JitTraceReport::Clear() -> void
+{
+    m_events.clear();
+    m_next_event = 0;
+    m_counts = {};
+    m_aborts_by_location.clear();
+    m_aborts_by_reason.clear();
+}
+auto JitTraceReport::GetEvents() const -> std::vector<JitTraceEvent>
+{
+    // oldest first, which is m_next_event once the ring wrapped
+    auto first = m_events.size() < m_event_capacity ? 0 : m_next_event;
+
+    std::vector<JitTraceEvent> events;
+    events.reserve(m_events.size());
+
+    for (size_t i = 0; i < m_events.size(); ++i) {
+        events.push_back(m_events[(first + i) % m_events.size()]);
+    }
+
+    return events;
+}
+auto JitTraceReport::Count(JitTraceEventType type) const -> size_t
+{
+    return m_counts[static_cast<size_t>(type)];
+}
+auto JitTraceReport::GetAbortsByLocation() const
+    -> const std::map<std::string, size_t>&
+{
+    return m_aborts_by_location;
+}
+auto JitTraceReport::GetAbortsByReason() const
+    -> const std::map<std::string, size_t>&
+{
+    return m_aborts_by_reason;
+}
+} // namespace kdk::glua
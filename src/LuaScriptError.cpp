@@ -0,0 +1,70 @@
+#include "glua/LuaScriptError.h"
+
+extern "C" {
+#include "lauxlib.h"
+}
+
+namespace kdk::glua {
+LuaScriptError::LuaScriptError(std::string function_name,
+    std::string error_message, ScriptErrorDetails details)
+    : exceptions::LuaException("Lua script error")
+    , m_state(std::make_shared<ErrorState>(ErrorState { std::move(function_name),
+          std::move(error_message), std::move(details), std::nullopt }))
+{
+}
+auto LuaScriptError::ErrorValueToString(lua_State* lua, int stack_index)
+    -> std::string
+{
+    auto type = lua_type(lua, stack_index);
+
+    if (type != LUA_TSTRING && type != LUA_TNUMBER) {
+        return std::string { "(error object is a " } + luaL_typename(lua, stack_index)
+            + " value)";
+    }
+
+    // converting a number in place is fine, the error value is discarded
+    size_t length = 0;
+    const auto* value = lua_tolstring(lua, stack_index, &length);
+
+    return std::string { value, length };
+}
+auto LuaScriptError::what() const noexcept -> const char*
+{
+    try {
+        if (!m_state->message.has_value()) {
+            std::string message = m_state->function_name.empty()
+                ? "Failed to call script: "
+                : "Failed to call lua script function [" + m_state->function_name + "]: ";
+
+            message.append(m_state->error_message);
+
+            if (m_state->details.traceback.has_value()) {
+                message.append("\n").append(m_state->details.traceback.value());
+            }
+
+            m_state->message = std::move(message);
+        }
+
+        return m_state->message->c_str();
+    } catch (...) {
+        return exceptions::LuaException::what();
+    }
+}
+auto LuaScriptError::GetFunctionName() const -> const std::string&
+{
+    return m_state->function_name;
+}
+auto LuaScriptError::GetChunk() const -> const std::string&
+{
+    return m_state->details.chunk;
+}
+auto LuaScriptError::GetLine() const -> int { return m_state->details.line; }
+auto LuaScriptError::GetTraceback() const -> const std::optional<std::string>&
+{
+    return m_state->details.traceback;
+}
+auto LuaScriptError::GetErrorMessage() const -> const std::string&
+{
+    return m_state->error_message;
+}
+} // namespace kdk::glua
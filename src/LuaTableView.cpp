@@ -0,0 +1,156 @@
+#include "glua/LuaTableView.h"
+
+#include "glua/GluaBase.h"
+
+namespace kdk::glua {
+LuaTableView::LuaTableView(GluaBase* glua, int stack_index)
+    : m_glua(glua)
+    , m_stack_index(glua->absoluteStackIndex(stack_index))
+{
+}
+
+auto LuaTableView::GetStackIndex() const -> int { return m_stack_index; }
+
+auto LuaTableView::Length() const -> size_t
+{
+    return m_glua->getArraySize(m_stack_index);
+}
+
+auto LuaTableView::Contains(std::string_view key) const -> bool
+{
+    m_glua->getMapValue(key, m_stack_index);
+    auto contains = !m_glua->isNull(-1);
+    m_glua->popOffStack(1);
+
+    return contains;
+}
+
+auto LuaTableView::PushChild(std::string_view key) const -> StackPosition
+{
+    m_glua->getMapValue(key, m_stack_index);
+
+    return StackPosition { m_glua, m_glua->getStackTop() };
+}
+
+auto LuaTableView::PushChild(size_t index) const -> StackPosition
+{
+    m_glua->getArrayValue(m_glua->transformObjectIndex(index), m_stack_index);
+
+    return StackPosition { m_glua, m_glua->getStackTop() };
+}
+
+auto LuaTableView::begin() const -> Iterator
+{
+    return Iterator { m_glua, m_stack_index };
+}
+
+auto LuaTableView::end() const -> Sentinel { return Sentinel {}; }
+
+LuaTableView::Entry::Entry(GluaBase* glua, int key_index)
+    : m_glua(glua)
+    , m_key_index(key_index)
+{
+}
+
+auto LuaTableView::Entry::GetValueIndex() const -> int
+{
+    return m_key_index + 1; // value is always pushed right after the key
+}
+
+LuaTableView::Iterator::Iterator(GluaBase* glua, int table_index)
+    : m_glua(glua)
+    , m_table_index(table_index)
+    , m_active(false)
+    , m_entry(glua, 0)
+{
+    // null key starts the iteration
+    m_glua->push(std::nullopt);
+    advance();
+}
+
+LuaTableView::Iterator::Iterator(Iterator&& rhs) noexcept
+    : m_glua(rhs.m_glua)
+    , m_table_index(rhs.m_table_index)
+    , m_active(rhs.m_active)
+    , m_entry(rhs.m_entry)
+{
+    rhs.m_active = false;
+}
+
+auto LuaTableView::Iterator::operator=(Iterator&& rhs) noexcept -> Iterator&
+{
+    if (this == &rhs) {
+        return *this;
+    }
+
+    if (m_active) {
+        // the replaced key and value may be below rhs's, so they're removed
+        // where they are instead of popped
+        auto key_index = m_entry.GetValueIndex() - 1;
+        m_glua->removeFromStack(key_index + 1);
+        m_glua->removeFromStack(key_index);
+
+        if (rhs.m_active && rhs.m_entry.GetValueIndex() > key_index) {
+            rhs.m_entry = Entry { rhs.m_glua, rhs.m_entry.GetValueIndex() - 3 };
+        }
+        if (rhs.m_table_index > key_index) {
+            rhs.m_table_index -= 2;
+        }
+    }
+
+    m_glua = rhs.m_glua;
+    m_table_index = rhs.m_table_index;
+    m_active = rhs.m_active;
+    m_entry = rhs.m_entry;
+
+    rhs.m_active = false;
+
+    return *this;
+}
+
+auto LuaTableView::Iterator::operator*() const -> const Entry&
+{
+    return m_entry;
+}
+
+auto LuaTableView::Iterator::operator->() const -> const Entry*
+{
+    return &m_entry;
+}
+
+auto LuaTableView::Iterator::operator++() -> Iterator&
+{
+    // pop the value, leaving the key for the next iteration
+    m_glua->popOffStack(1);
+    advance();
+
+    return *this;
+}
+
+auto LuaTableView::Iterator::operator!=(Sentinel /*unused*/) const -> bool
+{
+    return m_active;
+}
+
+auto LuaTableView::Iterator::operator==(Sentinel /*unused*/) const -> bool
+{
+    return !m_active;
+}
+
+auto LuaTableView::Iterator::advance() -> void
+{
+    // when iteration finishes the key is popped and nothing is pushed
+    m_active = m_glua->nextMapEntry(m_table_index);
+
+    if (m_active) {
+        m_entry = Entry { m_glua, m_glua->getStackTop() - 1 };
+    }
+}
+
+LuaTableView::Iterator::~Iterator()
+{
+    if (m_active) {
+        m_glua->popOffStack(2); // key and value
+    }
+}
+} // namespace kdk::glua
@@ -0,0 +1,150 @@
+#include "glua/PrintSink.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace kdk::glua {
+OStreamPrintSink::OStreamPrintSink(std::ostream& output_stream)
+    : m_output_stream(output_stream)
+{
+}
+
+auto OStreamPrintSink::Write(std::string_view line) -> void
+{
+    m_output_stream.get().write(line.data(), static_cast<std::streamsize>(line.size()));
+    m_output_stream.get().put('\n');
+}
+
+auto OStreamPrintSink::Flush() -> void
+{
+    m_output_stream.get().flush();
+}
+
+static auto round_up_to_power_of_two(size_t value) -> size_t
+{
+    size_t power = 1;
+
+    while (power < value) {
+        power <<= 1u;
+    }
+
+    return power;
+}
+
+BufferedPrintSink::BufferedPrintSink(std::ostream& output_stream,
+    size_t capacity, std::chrono::milliseconds flush_interval)
+    : m_output_stream(output_stream)
+    , m_capacity(round_up_to_power_of_two(std::max<size_t>(capacity, 2)))
+    , m_flush_interval(flush_interval)
+    , m_head(0)
+    , m_tail(0)
+    , m_buffered_lines(0)
+    , m_dropped_lines(0)
+    , m_is_flush_requested(false)
+    , m_is_stopping(false)
+{
+    m_ring = std::make_unique<char[]>(m_capacity);
+    m_writer = std::thread { [this]() { runWriter(); } };
+}
+
+auto BufferedPrintSink::Write(std::string_view line) -> void
+{
+    auto head = m_head.load(std::memory_order_relaxed);
+    auto tail = m_tail.load(std::memory_order_acquire);
+    auto size = line.size() + 1; // with its newline
+
+    if (size > m_capacity - static_cast<size_t>(head - tail)) {
+        m_dropped_lines.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    auto mask = m_capacity - 1;
+    auto start = static_cast<size_t>(head) & mask;
+    auto first_part = std::min(line.size(), m_capacity - start);
+
+    std::memcpy(m_ring.get() + start, line.data(), first_part);
+    std::memcpy(m_ring.get(), line.data() + first_part, line.size() - first_part);
+    m_ring[(start + line.size()) & mask] = '\n';
+
+    m_head.store(head + size, std::memory_order_release);
+    m_buffered_lines.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto BufferedPrintSink::Flush() -> void
+{
+    auto head = m_head.load(std::memory_order_relaxed);
+
+    std::unique_lock<std::mutex> lock { m_writer_mutex };
+
+    m_is_flush_requested = true;
+    m_writer_wake.notify_one();
+
+    m_drained.wait(lock,
+        [this, head]() { return m_tail.load(std::memory_order_acquire) >= head; });
+}
+
+auto BufferedPrintSink::GetBufferedLineCount() const -> uint64_t
+{
+    return m_buffered_lines.load(std::memory_order_relaxed);
+}
+
+auto BufferedPrintSink::GetDroppedLineCount() const -> uint64_t
+{
+    return m_dropped_lines.load(std::memory_order_relaxed);
+}
+
+auto BufferedPrintSink::runWriter() -> void
+{
+    std::unique_lock<std::mutex> lock { m_writer_mutex };
+
+    while (!m_is_stopping) {
+        m_writer_wake.wait_for(lock, m_flush_interval,
+            [this]() { return m_is_flush_requested || m_is_stopping; });
+        m_is_flush_requested = false;
+
+        lock.unlock();
+        drain();
+        lock.lock();
+
+        // under the lock, so a flusher checking the tail can't miss it
+        m_drained.notify_all();
+    }
+
+    lock.unlock();
+    drain(); // lines written before stopping
+}
+
+auto BufferedPrintSink::drain() -> void
+{
+    auto tail = m_tail.load(std::memory_order_relaxed);
+    auto head = m_head.load(std::memory_order_acquire);
+
+    if (head == tail) {
+        return;
+    }
+
+    // every complete line between tail and head goes out as one batch
+    auto& output_stream = m_output_stream.get();
+    auto start = static_cast<size_t>(tail) & (m_capacity - 1);
+    auto size = static_cast<size_t>(head - tail);
+    auto first_part = std::min(size, m_capacity - start);
+
+    output_stream.write(m_ring.get() + start, static_cast<std::streamsize>(first_part));
+    output_stream.write(m_ring.get(), static_cast<std::streamsize>(size - first_part));
+    output_stream.flush();
+
+    m_tail.store(head, std::memory_order_release);
+}
+
+BufferedPrintSink::~BufferedPrintSink()
+{
+    {
+        std::lock_guard<std::mutex> lock { m_writer_mutex };
+        m_is_stopping = true;
+    }
+
+    m_writer_wake.notify_one();
+    m_writer.join();
+}
+
+} // namespace kdk::glua
@@ -0,0 +1,353 @@
+#include "glua/ScriptMetrics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <utility>
+
+namespace kdk::glua {
+// position of the highest set bit, value must not be 0
+static auto highest_bit(uint64_t value) -> unsigned
+{
+    unsigned bit = 0;
+
+    for (unsigned shift = 32; shift > 0; shift >>= 1u) {
+        if ((value >> shift) != 0) {
+            value >>= shift;
+            bit += shift;
+        }
+    }
+
+    return bit;
+}
+
+// a counter only its state's thread writes
+static auto increment_single_writer(std::atomic<uint64_t>& counter, uint64_t amount) -> void
+{
+    counter.store(counter.load(std::memory_order_relaxed) + amount,
+        std::memory_order_relaxed);
+}
+
+auto LatencyHistogram::Record(uint64_t value) -> void
+{
+    increment_single_writer(m_counts[BucketOf(value)], 1);
+}
+
+auto LatencyHistogram::GetBucketCount(size_t bucket) const -> uint64_t
+{
+    return m_counts[bucket].load(std::memory_order_relaxed);
+}
+
+auto LatencyHistogram::BucketOf(uint64_t value) -> size_t
+{
+    constexpr uint64_t sub_bucket_count = 1u << sub_bucket_bits;
+    constexpr uint64_t max_value = (uint64_t { 1 } << max_value_bits) - 1;
+
+    value = std::min(value, max_value);
+
+    if (value < sub_bucket_count) {
+        return static_cast<size_t>(value);
+    }
+
+    // the top sub_bucket_bits below the highest bit pick the sub bucket
+    auto exponent = highest_bit(value);
+    auto sub_bucket = (value >> (exponent - sub_bucket_bits)) & (sub_bucket_count - 1);
+
+    return static_cast<size_t>(((exponent - sub_bucket_bits + 1) << sub_bucket_bits) + sub_bucket);
+}
+
+auto LatencyHistogram::BucketUpperBound(size_t bucket) -> uint64_t
+{
+    constexpr size_t sub_bucket_count = 1u << sub_bucket_bits;
+
+    if (bucket < sub_bucket_count) {
+        return bucket;
+    }
+
+    auto exponent = static_cast<unsigned>(bucket >> sub_bucket_bits) + sub_bucket_bits - 1;
+    auto sub_bucket = static_cast<uint64_t>(bucket & (sub_bucket_count - 1));
+    auto width = uint64_t { 1 } << (exponent - sub_bucket_bits);
+
+    return ((sub_bucket_count + sub_bucket) << (exponent - sub_bucket_bits)) + width - 1;
+}
+
+auto CallMetricsSnapshot::LatencyAtQuantile(double quantile) const -> uint64_t
+{
+    if (call_count == 0) {
+        return 0;
+    }
+
+    auto rank = static_cast<uint64_t>(quantile * static_cast<double>(call_count));
+    rank = std::max<uint64_t>(rank, 1);
+
+    uint64_t seen = 0;
+
+    for (size_t bucket = 0; bucket < latency_buckets.size(); ++bucket) {
+        seen += latency_buckets[bucket];
+
+        if (seen >= rank) {
+            return LatencyHistogram::BucketUpperBound(bucket);
+        }
+    }
+
+    // counts read while the state ran may be a little ahead of the buckets
+    return LatencyHistogram::BucketUpperBound(latency_buckets.size() - 1);
+}
+
+CallStats::CallStats(std::string name)
+    : m_name(std::move(name))
+    , m_call_count(0)
+    , m_error_count(0)
+    , m_total_ns(0)
+{
+}
+
+auto CallStats::Record(uint64_t duration_ns, bool is_error) -> void
+{
+    increment_single_writer(m_call_count, 1);
+    increment_single_writer(m_total_ns, duration_ns);
+
+    if (is_error) {
+        increment_single_writer(m_error_count, 1);
+    }
+
+    m_latency.Record(duration_ns);
+}
+
+auto CallStats::Snapshot() const -> CallMetricsSnapshot
+{
+    CallMetricsSnapshot snapshot {
+        m_name, m_call_count.load(std::memory_order_relaxed),
+        m_error_count.load(std::memory_order_relaxed),
+        m_total_ns.load(std::memory_order_relaxed), {}
+    };
+
+    snapshot.latency_buckets.resize(LatencyHistogram::bucket_count);
+
+    for (size_t bucket = 0; bucket < LatencyHistogram::bucket_count; ++bucket) {
+        snapshot.latency_buckets[bucket] = m_latency.GetBucketCount(bucket);
+    }
+
+    return snapshot;
+}
+
+auto CallStats::Now() -> uint64_t
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+CallableMetricsSlot::CallableMetricsSlot(ScriptMetrics& metrics, std::string name)
+    : m_metrics(&metrics)
+    , m_name(std::move(name))
+    , m_stats(nullptr)
+{
+}
+
+auto CallableMetricsSlot::IsEnabled() const -> bool
+{
+    return m_metrics->IsEnabled();
+}
+
+auto CallableMetricsSlot::GetStats() -> CallStats&
+{
+    if (m_stats == nullptr) {
+        m_stats = &m_metrics->AddCallableStats(m_name);
+    }
+
+    return *m_stats;
+}
+
+ScriptMetrics::ScriptMetrics()
+    : m_is_enabled(false)
+    , m_gc_cycle_count(nullptr)
+    , m_memory_bytes(0)
+{
+}
+
+auto ScriptMetrics::SetEnabled(bool enabled) -> void
+{
+    m_is_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+auto ScriptMetrics::GetScriptFunctionStats(const std::string& function_name)
+    -> CallStats&
+{
+    auto stats_pos = m_script_functions.find(function_name);
+
+    if (stats_pos != m_script_functions.end()) {
+        return *stats_pos->second;
+    }
+
+    std::lock_guard<std::mutex> lock { m_stats_mutex };
+
+    return *m_script_functions.emplace(function_name,
+                                  std::make_unique<CallStats>(function_name))
+                .first->second;
+}
+
+auto ScriptMetrics::AddCallable(std::string name) -> CallableMetricsSlot*
+{
+    m_callable_slots.push_back(
+        std::make_unique<CallableMetricsSlot>(*this, std::move(name)));
+
+    return m_callable_slots.back().get();
+}
+
+auto ScriptMetrics::AddCallableStats(const std::string& name) -> CallStats&
+{
+    std::lock_guard<std::mutex> lock { m_stats_mutex };
+
+    m_callables.push_back(std::make_unique<CallStats>(name));
+
+    return *m_callables.back();
+}
+
+auto ScriptMetrics::SetGcCycleCounter(const std::atomic<uint64_t>* gc_cycle_count)
+    -> void
+{
+    m_gc_cycle_count.store(gc_cycle_count, std::memory_order_release);
+}
+
+auto ScriptMetrics::SetMemoryBytes(uint64_t memory_bytes) -> void
+{
+    m_memory_bytes.store(memory_bytes, std::memory_order_relaxed);
+}
+
+auto ScriptMetrics::Snapshot() const -> MetricsSnapshot
+{
+    MetricsSnapshot snapshot {};
+
+    {
+        std::lock_guard<std::mutex> lock { m_stats_mutex };
+
+        snapshot.script_functions.reserve(m_script_functions.size());
+
+        for (const auto& stats_pair : m_script_functions) {
+            snapshot.script_functions.push_back(stats_pair.second->Snapshot());
+        }
+
+        snapshot.callables.reserve(m_callables.size());
+
+        for (const auto& stats : m_callables) {
+            snapshot.callables.push_back(stats->Snapshot());
+        }
+    }
+
+    const auto* gc_cycle_count = m_gc_cycle_count.load(std::memory_order_acquire);
+
+    snapshot.gc_cycle_count = gc_cycle_count != nullptr
+        ? gc_cycle_count->load(std::memory_order_relaxed)
+        : 0;
+    snapshot.memory_bytes = m_memory_bytes.load(std::memory_order_relaxed);
+
+    return snapshot;
+}
+
+static auto append_label_value(std::string& text, const std::string& value) -> void
+{
+    for (auto character : value) {
+        switch (character) {
+        case '\\':
+            text += "\\\\";
+            break;
+        case '"':
+            text += "\\\"";
+            break;
+        case '\n':
+            text += "\\n";
+            break;
+        default:
+            text += character;
+        }
+    }
+}
+
+static auto append_seconds(std::string& text, uint64_t nanoseconds) -> void
+{
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%.9g",
+        static_cast<double>(nanoseconds) / 1e9);
+
+    text += buffer;
+}
+
+static constexpr std::array<std::pair<const char*, double>, 4> summary_quantiles { {
+    { "0.5", 0.5 }, { "0.9", 0.9 }, { "0.99", 0.99 }, { "0.999", 0.999 } } };
+
+static auto append_call_metrics(std::string& text, std::string_view prefix,
+    std::string_view kind, std::string_view label,
+    const std::vector<CallMetricsSnapshot>& calls) -> void
+{
+    if (calls.empty()) {
+        return;
+    }
+
+    auto metric = std::string { prefix } + "_" + std::string { kind };
+    auto append_labels = [&](const CallMetricsSnapshot& call) {
+        text += '{';
+        text += label;
+        text += "=\"";
+        append_label_value(text, call.name);
+        text += '"';
+    };
+
+    text += "# TYPE " + metric + "_calls_total counter\n";
+
+    for (const auto& call : calls) {
+        text += metric + "_calls_total";
+        append_labels(call);
+        text += "} " + std::to_string(call.call_count) + "\n";
+    }
+
+    text += "# TYPE " + metric + "_errors_total counter\n";
+
+    for (const auto& call : calls) {
+        text += metric + "_errors_total";
+        append_labels(call);
+        text += "} " + std::to_string(call.error_count) + "\n";
+    }
+
+    text += "# TYPE " + metric + "_latency_seconds summary\n";
+
+    for (const auto& call : calls) {
+        for (auto [quantile_label, quantile] : summary_quantiles) {
+            text += metric + "_latency_seconds";
+            append_labels(call);
+            text += ",quantile=\"";
+            text += quantile_label;
+            text += "\"} ";
+            append_seconds(text, call.LatencyAtQuantile(quantile));
+            text += '\n';
+        }
+
+        text += metric + "_latency_seconds_sum";
+        append_labels(call);
+        text += "} ";
+        append_seconds(text, call.total_ns);
+        text += '\n';
+
+        text += metric + "_latency_seconds_count";
+        append_labels(call);
+        text += "} " + std::to_string(call.call_count) + "\n";
+    }
+}
+
+auto MetricsSnapshot::ToPrometheusText(std::string_view prefix) const -> std::string
+{
+    std::string text;
+    auto metric_prefix = std::string { prefix };
+
+    append_call_metrics(text, prefix, "script_function", "function", script_functions);
+    append_call_metrics(text, prefix, "callable", "callable", callables);
+
+    text += "# TYPE " + metric_prefix + "_gc_cycles_total counter\n";
+    text += metric_prefix + "_gc_cycles_total " + std::to_string(gc_cycle_count) + "\n";
+    text += "# TYPE " + metric_prefix + "_memory_bytes gauge\n";
+    text += metric_prefix + "_memory_bytes " + std::to_string(memory_bytes) + "\n";
+
+    return text;
+}
+
+} // namespace kdk::glua
@@ -0,0 +1,307 @@
+#include "glua/ScriptTracer.h"
+#include "glua/FileUtil.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace kdk::glua::script_tracer {
+namespace detail {
+    std::atomic<bool> is_enabled { false };
+
+    auto now() -> uint64_t
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+} // namespace detail
+
+struct TraceEvent {
+    const std::string* name;
+    uint64_t start_ns;
+    uint64_t duration_ns;
+};
+
+// scripts can name spans dynamically, names beyond this share one name
+constexpr size_t max_names_per_thread = 4096;
+
+/**
+ * The spans of one thread. Only its thread writes to it, the mutex is only
+ * contended while starting or exporting
+ */
+struct ThreadTraceBuffer {
+    std::mutex mutex;
+    uint32_t thread_id = 0;
+    std::vector<TraceEvent> events; // ring, next_event is the oldest once full
+    size_t next_event = 0;
+    size_t capacity = 0;
+    // names are kept until tracing restarts, so spans only store a pointer
+    std::unordered_map<std::string_view, std::unique_ptr<std::string>> names;
+    std::string overflow_name = "(too many span names)";
+    std::vector<std::pair<const std::string*, uint64_t>> open_spans;
+
+    auto intern(std::string_view name) -> const std::string*
+    {
+        auto name_pos = names.find(name);
+
+        if (name_pos != names.end()) {
+            return name_pos->second.get();
+        }
+
+        if (names.size() >= max_names_per_thread) {
+            return &overflow_name;
+        }
+
+        auto owned_name = std::make_unique<std::string>(name);
+        const auto* name_ptr = owned_name.get();
+        names.emplace(std::string_view { *name_ptr }, std::move(owned_name));
+
+        return name_ptr;
+    }
+
+    auto add(const TraceEvent& event) -> void
+    {
+        if (capacity == 0) {
+            return;
+        }
+
+        if (events.size() < capacity) {
+            events.push_back(event);
+        } else {
+            events[next_event] = event;
+        }
+
+        next_event = (next_event + 1) % capacity;
+    }
+
+    auto reset(size_t new_capacity) -> void
+    {
+        events.clear();
+        events.shrink_to_fit();
+        next_event = 0;
+        capacity = new_capacity;
+        open_spans.clear();
+        names.clear(); // no event refers to them anymore
+    }
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers; // outlive their threads
+    size_t events_per_thread = default_events_per_thread;
+    uint32_t next_thread_id = 1;
+};
+
+static auto trace_registry() -> TraceRegistry&
+{
+    static TraceRegistry registry;
+
+    return registry;
+}
+
+static auto thread_trace_buffer() -> ThreadTraceBuffer&
+{
+    thread_local std::shared_ptr<ThreadTraceBuffer> buffer = []() {
+        auto& registry = trace_registry();
+        std::lock_guard<std::mutex> lock { registry.mutex };
+
+        auto new_buffer = std::make_shared<ThreadTraceBuffer>();
+        new_buffer->thread_id = registry.next_thread_id++;
+        new_buffer->capacity = registry.events_per_thread;
+        registry.buffers.push_back(new_buffer);
+
+        return new_buffer;
+    }();
+
+    return *buffer;
+}
+
+namespace detail {
+    auto record_span(std::string_view name, uint64_t start_ns, uint64_t end_ns)
+        -> void
+    {
+        if (!script_tracer::is_enabled()) {
+            return;
+        }
+
+        auto& buffer = thread_trace_buffer();
+        std::lock_guard<std::mutex> lock { buffer.mutex };
+
+        try {
+            buffer.add(TraceEvent { buffer.intern(name), start_ns, end_ns - start_ns });
+        } catch (const std::bad_alloc&) {
+            // called from destructors, losing a span is better than terminating
+        }
+    }
+} // namespace detail
+
+auto start(size_t events_per_thread) -> void
+{
+    auto& registry = trace_registry();
+    std::lock_guard<std::mutex> lock { registry.mutex };
+
+    registry.events_per_thread = events_per_thread;
+
+    for (auto& buffer : registry.buffers) {
+        std::lock_guard<std::mutex> buffer_lock { buffer->mutex };
+        buffer->reset(events_per_thread);
+    }
+
+    detail::is_enabled.store(true, std::memory_order_relaxed);
+}
+
+auto stop() -> void
+{
+    detail::is_enabled.store(false, std::memory_order_relaxed);
+}
+
+auto begin_span(std::string_view name) -> void
+{
+    if (!is_enabled()) {
+        return;
+    }
+
+    auto& buffer = thread_trace_buffer();
+    std::lock_guard<std::mutex> lock { buffer.mutex };
+
+    buffer.open_spans.emplace_back(buffer.intern(name), detail::now());
+}
+
+auto end_span() -> void
+{
+    if (!is_enabled()) {
+        return;
+    }
+
+    auto& buffer = thread_trace_buffer();
+    std::lock_guard<std::mutex> lock { buffer.mutex };
+
+    // unbalanced ends, e.g. after tracing was restarted, are ignored
+    if (buffer.open_spans.empty()) {
+        return;
+    }
+
+    auto [name, start_ns] = buffer.open_spans.back();
+    buffer.open_spans.pop_back();
+
+    buffer.add(TraceEvent { name, start_ns, detail::now() - start_ns });
+}
+
+auto open_span_depth() -> size_t
+{
+    auto& buffer = thread_trace_buffer();
+    std::lock_guard<std::mutex> lock { buffer.mutex };
+
+    return buffer.open_spans.size();
+}
+
+auto end_spans_above(size_t depth) -> void
+{
+    if (!is_enabled()) {
+        return;
+    }
+
+    auto& buffer = thread_trace_buffer();
+    std::lock_guard<std::mutex> lock { buffer.mutex };
+
+    auto end_ns = detail::now();
+
+    // innermost first, as end_span would have closed them
+    while (buffer.open_spans.size() > depth) {
+        auto [name, start_ns] = buffer.open_spans.back();
+        buffer.open_spans.pop_back();
+
+        buffer.add(TraceEvent { name, start_ns, end_ns - start_ns });
+    }
+}
+
+static auto append_json_string(std::string& json, const std::string& value) -> void
+{
+    json += '"';
+
+    for (auto character : value) {
+        switch (character) {
+        case '"':
+            json += "\\\"";
+            break;
+        case '\\':
+            json += "\\\\";
+            break;
+        default:
+            if (static_cast<unsigned char>(character) < 0x20) {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x",
+                    static_cast<unsigned>(character));
+                json += escaped;
+            } else {
+                json += character;
+            }
+        }
+    }
+
+    json += '"';
+}
+
+static auto append_microseconds(std::string& json, uint64_t nanoseconds) -> void
+{
+    json += std::to_string(nanoseconds / 1000);
+    json += '.';
+
+    auto fraction = std::to_string(nanoseconds % 1000);
+    json.append(3 - fraction.size(), '0');
+    json += fraction;
+}
+
+auto export_chrome_trace() -> std::string
+{
+    auto& registry = trace_registry();
+    std::lock_guard<std::mutex> lock { registry.mutex };
+
+    std::string json = "{\"traceEvents\":[";
+    auto is_first_event = true;
+
+    for (auto& buffer : registry.buffers) {
+        std::lock_guard<std::mutex> buffer_lock { buffer->mutex };
+
+        // oldest first, which is next_event once the ring wrapped
+        auto first = buffer->events.size() < buffer->capacity ? 0 : buffer->next_event;
+
+        for (size_t i = 0; i < buffer->events.size(); ++i) {
+            const auto& event = buffer->events[(first + i) % buffer->events.size()];
+
+            if (!is_first_event) {
+                json += ',';
+            }
+            is_first_event = false;
+
+            // complete events, so spans overwritten in the ring or cut short
+            // by an error never leave an unmatched begin or end behind
+            json += "\n{\"name\":";
+            append_json_string(json, *event.name);
+            json += ",\"ph\":\"X\",\"pid\":1,\"tid\":";
+            json += std::to_string(buffer->thread_id);
+            json += ",\"ts\":";
+            append_microseconds(json, event.start_ns);
+            json += ",\"dur\":";
+            append_microseconds(json, event.duration_ns);
+            json += '}';
+        }
+    }
+
+    json += "\n],\"displayTimeUnit\":\"ns\"}\n";
+
+    return json;
+}
+
+auto write_chrome_trace(std::string_view filename) -> void
+{
+    file_util::write_all(filename, export_chrome_trace());
+}
+
+} // namespace kdk::glua::script_tracer
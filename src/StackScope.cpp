@@ -0,0 +1,56 @@
+#include "glua/StackScope.h"
+
+#include "glua/GluaBase.h"
+
+#include <stdexcept>
+
+namespace kdk::glua {
+StackScope::StackScope(GluaBase* glua)
+    : m_glua(glua)
+    , m_top(glua->getStackTop())
+{
+}
+
+auto StackScope::GetTop() const -> int { return m_top; }
+
+auto StackScope::PushChild(int parent_index, size_t child_index) -> int
+{
+    m_glua->getArrayValue(m_glua->transformObjectIndex(child_index), parent_index);
+
+    return m_glua->getStackTop();
+}
+
+auto StackScope::PushChild(int parent_index, std::string_view child_key) -> int
+{
+    m_glua->getMapValue(child_key, parent_index);
+
+    return m_glua->getStackTop();
+}
+
+auto StackScope::SafePushChild(int parent_index, size_t child_index) -> int
+{
+    auto result_index = PushChild(parent_index, child_index);
+
+    if (m_glua->isNull(result_index)) {
+        throw std::out_of_range("StackScope::SafePushChild with unset index");
+    }
+
+    return result_index;
+}
+
+auto StackScope::SafePushChild(int parent_index, std::string_view child_key)
+    -> int
+{
+    auto result_index = PushChild(parent_index, child_key);
+
+    if (m_glua->isNull(result_index)) {
+        throw std::out_of_range("StackScope::SafePushChild with unset key");
+    }
+
+    return result_index;
+}
+
+auto StackScope::Restore() -> void { m_glua->setStackTop(m_top); }
+
+StackScope::~StackScope() { m_glua->setStackTop(m_top); }
+} // namespace kdk::glua
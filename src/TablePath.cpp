@@ -0,0 +1,110 @@
+#include "glua/TablePath.h"
+
+#include "glua/GluaBase.h"
+
+#include <algorithm>
+#include <charconv>
+
+namespace kdk::glua {
+TablePath::TablePath(GluaBase* glua, std::string_view path)
+    : m_glua(glua)
+    , m_path(path)
+{
+    auto throw_invalid = [&](const char* reason) {
+        throw exceptions::GluaBaseException(
+            "Invalid table path \"" + m_path + "\": " + reason);
+    };
+
+    size_t pos = 0;
+
+    while (pos < path.size()) {
+        if (path[pos] == '[') {
+            auto close_pos = path.find(']', pos);
+
+            if (close_pos == std::string_view::npos) {
+                throw_invalid("unterminated index");
+            }
+
+            size_t index = 0;
+            const auto* digits_begin = path.data() + pos + 1;
+            const auto* digits_end = path.data() + close_pos;
+            auto [parse_end, error] = std::from_chars(digits_begin, digits_end, index);
+
+            if (digits_begin == digits_end || error != std::errc {}
+                || parse_end != digits_end) {
+                throw_invalid("index is not a non-negative integer");
+            }
+
+            m_segments.push_back(
+                TablePathSegment { 0, glua->transformObjectIndex(index), true });
+            pos = close_pos + 1;
+        } else {
+            auto key_end = std::min(path.find_first_of(".[", pos), path.size());
+
+            if (key_end == pos) {
+                throw_invalid("empty key");
+            }
+
+            auto key = path.substr(pos, key_end - pos);
+
+            if (m_segments.empty()) {
+                m_global_name = std::string { key };
+            }
+
+            m_segments.push_back(
+                TablePathSegment { glua->internPathKey(key), 0, false });
+            pos = key_end;
+        }
+
+        // a key or index is followed by the end, an index, or `.` and a key
+        if (pos < path.size() && path[pos] == '.') {
+            ++pos;
+
+            if (pos == path.size() || path[pos] == '[' || path[pos] == '.') {
+                throw_invalid("empty key");
+            }
+        } else if (pos < path.size() && path[pos] != '[') {
+            throw_invalid("expected '.' or '[' after an index");
+        }
+    }
+
+    if (m_segments.empty()) {
+        throw_invalid("empty path");
+    }
+}
+
+auto TablePath::GetPath() const -> const std::string& { return m_path; }
+
+auto TablePath::Push(int stack_index) const -> StackPosition
+{
+    pushValue(stack_index);
+
+    return StackPosition { m_glua, m_glua->getStackTop() };
+}
+
+auto TablePath::PushGlobal() const -> StackPosition
+{
+    pushGlobalValue();
+
+    return StackPosition { m_glua, m_glua->getStackTop() };
+}
+
+auto TablePath::pushValue(int stack_index) const -> void
+{
+    m_glua->pushValueCopy(stack_index);
+    m_glua->walkTablePath(m_segments.data(), m_segments.size());
+}
+
+auto TablePath::pushGlobalValue() const -> void
+{
+    if (m_segments.front().is_index) {
+        throw exceptions::GluaBaseException(
+            "Table path \"" + m_path + "\" doesn't start with a global name");
+    }
+
+    // globals can be inherited by the sandbox environment, so only the global
+    // itself is looked up with metatables
+    m_glua->pushGlobal(m_global_name);
+    m_glua->walkTablePath(m_segments.data() + 1, m_segments.size() - 1);
+}
+} // namespace kdk::glua
@@ -0,0 +1,236 @@
+#include <glua/GluaBackend.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// each loop is called once to warm up (letting the JIT record its traces)
+// before it's timed. overloaded_loop calls the second of two overloads,
+// ffi_loop only runs with the LuaJIT backend, property_loop and method_loop
+// read and write the same field as a property and through getter and setter
+// methods
+static constexpr auto benchmark_script = R"lua(
+function callable_loop(iterations)
+    local total = 0
+    for i = 1, iterations do
+        total = benchmark_add(total, i)
+    end
+    return total
+end
+
+function overloaded_loop(iterations)
+    local total = 0
+    for i = 1, iterations do
+        total = benchmark_overloaded(total, i)
+    end
+    return total
+end
+
+function ffi_loop(iterations)
+    local total = 0
+    for i = 1, iterations do
+        total = benchmark_add_ffi(total, i)
+    end
+    return total
+end
+
+function property_loop(iterations)
+    local accumulator = ConstructBenchmarkAccumulator()
+    for i = 1, iterations do
+        accumulator.total = accumulator.total + i
+    end
+    return accumulator.total
+end
+
+function method_loop(iterations)
+    local accumulator = ConstructBenchmarkAccumulator()
+    for i = 1, iterations do
+        accumulator:SetTotal(accumulator:GetTotal() + i)
+    end
+    return accumulator:GetTotal()
+end
+
+function lua_loop(iterations)
+    local total = 0
+    for i = 1, iterations do
+        total = total + i
+    end
+    return total
+end
+)lua";
+
+static auto benchmark_add(double lhs, double rhs) -> double
+{
+    return lhs + rhs;
+}
+
+static auto benchmark_describe(std::string_view name) -> double
+{
+    return static_cast<double>(name.size());
+}
+
+#if !defined(GLUA_BACKEND_LUA54)
+static auto benchmark_add_ffi(double lhs, double rhs) -> double
+{
+    return lhs + rhs;
+}
+#endif
+
+struct BenchmarkAccumulator {
+    auto GetTotal() const -> double { return total; }
+    auto SetTotal(double value) -> void { total = value; }
+
+    double total = 0.0;
+};
+
+static auto benchmark_arity_0() -> double { return 1.0; }
+static auto benchmark_arity_1(double a) -> double { return a; }
+static auto benchmark_arity_2(double a, double b) -> double { return a + b; }
+static auto benchmark_arity_3(double a, double b, double c) -> double
+{
+    return a + b + c;
+}
+static auto benchmark_arity_4(double a, double b, double c, double d) -> double
+{
+    return a + b + c + d;
+}
+static auto benchmark_arity_5(double a, double b, double c, double d,
+    double e) -> double
+{
+    return a + b + c + d + e;
+}
+static auto benchmark_arity_6(double a, double b, double c, double d,
+    double e, double f) -> double
+{
+    return a + b + c + d + e + f;
+}
+
+/**
+ * Registers `function` twice, as `thunk_arity_N` called through its generated
+ * thunk and as `callable_arity_N` called through ICallable, and returns the
+ * script defining a loop calling each
+ */
+template <typename Function>
+static auto register_arity_benchmark(kdk::glua::GluaBackend& glua,
+    size_t arity, Function function) -> std::string
+{
+    auto suffix = "arity_" + std::to_string(arity);
+
+    glua.RegisterCallable("thunk_" + suffix, glua.CreateGluaCallable(function));
+
+    // wrapping the callable in another hides its thunk from the backend
+    glua.RegisterCallable("callable_" + suffix,
+        kdk::Callable { std::make_unique<kdk::Callable>(glua.CreateGluaCallable(function)) });
+
+    std::string arguments;
+    for (size_t i = 0; i < arity; ++i) {
+        arguments.append(i == 0 ? "i" : ", i");
+    }
+
+    std::string script;
+    for (const auto* prefix : { "thunk_", "callable_" }) {
+        auto name = prefix + suffix;
+
+        script.append("function " + name + "_loop(iterations)\n"
+            + "    local total = 0\n"
+            + "    for i = 1, iterations do\n"
+            + "        total = total + " + name + "(" + arguments + ")\n"
+            + "    end\n"
+            + "    return total\n"
+            + "end\n");
+    }
+
+    return script;
+}
+
+static auto run_loop_benchmark(kdk::glua::GluaBackend& glua,
+    const std::string& loop_name, size_t iterations) -> void
+{
+    glua.CallScriptFunction(loop_name, iterations);
+
+    auto start = std::chrono::steady_clock::now();
+    auto retvals = glua.CallScriptFunction(loop_name, iterations);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    auto nanoseconds = std::chrono::duration<double, std::nano> { elapsed }.count();
+
+    std::cout << std::left << std::setw(24) << loop_name << std::right
+              << std::setw(12) << std::fixed << std::setprecision(2)
+              << nanoseconds / static_cast<double>(iterations) << " ns/call"
+              << std::setw(12) << std::setprecision(1)
+              << static_cast<double>(iterations) * 1000.0 / nanoseconds
+              << " M calls/s  (result " << retvals[0].As<double>() << ")"
+              << std::endl;
+}
+
+auto main(int argc, char* argv[]) -> int
+{
+    size_t iterations = 10'000'000;
+
+    if (argc == 2) {
+        iterations = std::strtoull(argv[1], nullptr, 10);
+    } else if (argc > 2) {
+        std::cout << "Usage: " << argv[0] << " [iterations]" << std::endl;
+        return 1;
+    }
+
+    kdk::glua::GluaBackend glua { std::cout };
+
+    REGISTER_TO_GLUA(glua, benchmark_add);
+    glua.RegisterCallable("benchmark_overloaded",
+        glua.CreateGluaOverloads(&benchmark_describe, &benchmark_add));
+#if !defined(GLUA_BACKEND_LUA54)
+    REGISTER_FFI_TO_GLUA(glua, benchmark_add_ffi);
+#endif
+    REGISTER_CLASS_TO_GLUA(glua, BenchmarkAccumulator,
+        &BenchmarkAccumulator::GetTotal, &BenchmarkAccumulator::SetTotal);
+    glua.RegisterProperty<BenchmarkAccumulator>("total",
+        &BenchmarkAccumulator::total);
+
+    glua.RunScript(benchmark_script);
+
+    std::string arity_script = register_arity_benchmark(glua, 0, benchmark_arity_0)
+        + register_arity_benchmark(glua, 1, benchmark_arity_1)
+        + register_arity_benchmark(glua, 2, benchmark_arity_2)
+        + register_arity_benchmark(glua, 3, benchmark_arity_3)
+        + register_arity_benchmark(glua, 4, benchmark_arity_4)
+        + register_arity_benchmark(glua, 5, benchmark_arity_5)
+        + register_arity_benchmark(glua, 6, benchmark_arity_6);
+
+    glua.RunScript(arity_script);
+
+#if defined(GLUA_BACKEND_LUA54)
+    constexpr auto backend_name = "Lua 5.4";
+#else
+    constexpr auto backend_name = "LuaJIT";
+#endif
+
+    std::cout << backend_name << " loop throughput over " << iterations
+              << " iterations" << std::endl;
+
+    run_loop_benchmark(glua, "lua_loop", iterations);
+    run_loop_benchmark(glua, "callable_loop", iterations);
+    run_loop_benchmark(glua, "overloaded_loop", iterations);
+#if !defined(GLUA_BACKEND_LUA54)
+    run_loop_benchmark(glua, "ffi_loop", iterations);
+#endif
+    run_loop_benchmark(glua, "property_loop", iterations);
+    run_loop_benchmark(glua, "method_loop", iterations);
+
+    std::cout << std::endl
+              << "Bound call overhead by argument count, thunk vs ICallable"
+              << std::endl;
+
+    for (size_t arity = 0; arity <= 6; ++arity) {
+        auto suffix = "arity_" + std::to_string(arity) + "_loop";
+
+        run_loop_benchmark(glua, "thunk_" + suffix, iterations);
+        run_loop_benchmark(glua, "callable_" + suffix, iterations);
+    }
+
+    return 0;
+}
@@ -1,11 +1,17 @@
+#include <glua/BorrowTable.h>
 #include <glua/FileUtil.h>
-#include <glua/GluaLua.h>
+#include <glua/GluaBackend.h>
+#include <glua/ScriptTracer.h>
 
+#include <array>
+#include <cmath>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <tuple>
+#include <variant>
 
 class ExampleClass : public std::enable_shared_from_this<ExampleClass> {
 public:
@@ -63,7 +69,7 @@ static auto receive_optional_str(std::optional<std::string> o)
     }
 }
 
-static auto example_sandboxed_environment(kdk::glua::GluaLua& glua,
+static auto example_sandboxed_environment(kdk::glua::GluaBackend& glua,
     const std::string& script) -> void
 {
     std::cout << std::endl
@@ -80,7 +86,7 @@ static auto example_sandboxed_environment(kdk::glua::GluaLua& glua,
     glua.CallScriptFunction("example_sandboxed_environment");
 }
 
-static auto example_library_functions(kdk::glua::GluaLua& glua) -> void
+static auto example_library_functions(kdk::glua::GluaBackend& glua) -> void
 {
     std::cout << std::endl
               << __FUNCTION__ << " starting..." << std::endl;
@@ -88,7 +94,7 @@ static auto example_library_functions(kdk::glua::GluaLua& glua) -> void
     glua.CallScriptFunction("example_library_functions");
 }
 
-static auto example_managed_cpp_class(kdk::glua::GluaLua& glua) -> void
+static auto example_managed_cpp_class(kdk::glua::GluaBackend& glua) -> void
 {
     std::cout << std::endl
               << __FUNCTION__ << " starting..." << std::endl;
@@ -126,7 +132,7 @@ static auto example_binding(std::string_view some_str, double some_double)
     return stream.str();
 }
 
-static auto example_simple_binding(kdk::glua::GluaLua& glua) -> void
+static auto example_simple_binding(kdk::glua::GluaBackend& glua) -> void
 {
     std::cout << std::endl
               << __FUNCTION__ << " starting..." << std::endl;
@@ -134,7 +140,7 @@ static auto example_simple_binding(kdk::glua::GluaLua& glua) -> void
     glua.CallScriptFunction("example_simple_binding");
 }
 
-static auto example_global_value(kdk::glua::GluaLua& glua) -> void
+static auto example_global_value(kdk::glua::GluaBackend& glua) -> void
 {
     std::cout << std::endl
               << __FUNCTION__ << " starting..." << std::endl;
@@ -143,7 +149,7 @@ static auto example_global_value(kdk::glua::GluaLua& glua) -> void
     glua.CallScriptFunction("example_global_value");
 }
 
-static auto example_inferred_storage_cpp_class(kdk::glua::GluaLua& glua)
+static auto example_inferred_storage_cpp_class(kdk::glua::GluaBackend& glua)
     -> void
 {
     std::cout << std::endl
@@ -152,7 +158,7 @@ static auto example_inferred_storage_cpp_class(kdk::glua::GluaLua& glua)
     glua.CallScriptFunction("example_inferred_storage_cpp_class");
 }
 
-static auto example_callable_from_cpp(kdk::glua::GluaLua& glua) -> void
+static auto example_callable_from_cpp(kdk::glua::GluaBackend& glua) -> void
 {
     std::cout << std::endl
               << __FUNCTION__ << " starting..." << std::endl;
@@ -167,7 +173,7 @@ static auto example_callable_from_cpp(kdk::glua::GluaLua& glua) -> void
               << second_return << std::endl;
 }
 
-static auto example_reverse_array(kdk::glua::GluaLua& glua) -> void
+static auto example_reverse_array(kdk::glua::GluaBackend& glua) -> void
 {
     std::cout << std::endl
               << __FUNCTION__ << " starting..." << std::endl;
@@ -185,7 +191,7 @@ static auto example_reverse_array(kdk::glua::GluaLua& glua) -> void
     std::cout << std::endl;
 }
 
-static auto example_mutate_value(kdk::glua::GluaLua& glua) -> void
+static auto example_mutate_value(kdk::glua::GluaBackend& glua) -> void
 {
     std::cout << std::endl
               << __FUNCTION__ << " starting..." << std::endl;
@@ -201,7 +207,7 @@ static auto example_mutate_value(kdk::glua::GluaLua& glua) -> void
               << our_value.GetValue() << std::endl;
 }
 
-static auto example_create_and_retrieve_global(kdk::glua::GluaLua& glua)
+static auto example_create_and_retrieve_global(kdk::glua::GluaBackend& glua)
     -> void
 {
     std::cout << std::endl
@@ -217,7 +223,7 @@ enum class ExampleEnum { ONE = 1,
     TWO = 2,
     RED = 3,
     BLACK = 4 };
-static auto example_enumeration(kdk::glua::GluaLua& glua) -> void
+static auto example_enumeration(kdk::glua::GluaBackend& glua) -> void
 {
     std::cout << std::endl
               << __FUNCTION__ << " starting..." << std::endl;
@@ -278,7 +284,7 @@ struct GluaResolver<TemplateExample<ClassType, ValueType>> {
 };
 } // namespace kdk::glua
 
-static auto example_custom_template_binding(kdk::glua::GluaLua& glua) -> void
+static auto example_custom_template_binding(kdk::glua::GluaBackend& glua) -> void
 {
     std::cout << std::endl
               << __FUNCTION__ << " starting..." << std::endl;
@@ -289,7 +295,7 @@ static auto example_custom_template_binding(kdk::glua::GluaLua& glua) -> void
         TemplateExample<ExampleClass, int64_t> { 1337 });
 }
 
-static auto example_optionals(kdk::glua::GluaLua& glua) -> void
+static auto example_optionals(kdk::glua::GluaBackend& glua) -> void
 {
     std::cout << std::endl
               << __FUNCTION__ << " starting..." << std::endl;
@@ -306,7 +312,7 @@ static auto example_optionals(kdk::glua::GluaLua& glua) -> void
     glua.CallScriptFunction("example_optionals", opt_str, opt_int);
 }
 
-static auto example_nested_table(kdk::glua::GluaLua& glua) -> void
+static auto example_nested_table(kdk::glua::GluaBackend& glua) -> void
 {
     std::cout << std::endl
               << __FUNCTION__ << " starting..." << std::endl;
@@ -350,7 +356,7 @@ static auto example_nested_table(kdk::glua::GluaLua& glua) -> void
     }
 }
 
-static auto example_bind_lambda(kdk::glua::GluaLua& glua) -> void
+static auto example_bind_lambda(kdk::glua::GluaBackend& glua) -> void
 {
     std::cout << std::endl
               << __FUNCTION__ << " starting..." << std::endl;
@@ -367,7 +373,7 @@ static auto example_bind_lambda(kdk::glua::GluaLua& glua) -> void
     glua.CallScriptFunction("example_bind_lambda");
 }
 
-static auto example_lua_array(kdk::glua::GluaLua& glua) -> void
+static auto example_lua_array(kdk::glua::GluaBackend& glua) -> void
 {
     std::cout << std::endl
               << __FUNCTION__ << " starting..." << std::endl;
@@ -387,9 +393,519 @@ static auto example_lua_array(kdk::glua::GluaLua& glua) -> void
     }
 }
 
+struct ExampleRecord {
+    int64_t id;
+    double score;
+    std::string name;
+};
+
+// plain data structs are converted to and from tables field by field
+GLUA_STRUCT(ExampleRecord, &ExampleRecord::id, &ExampleRecord::score,
+    &ExampleRecord::name)
+
+static auto example_struct(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    ExampleRecord record { 7, 0.5, "seven" };
+
+    auto retvals = glua.CallScriptFunction("example_struct", record);
+    auto doubled = retvals[0].Get<ExampleRecord>();
+
+    std::cout << "example_struct returned: { id = " << doubled.id
+              << ", score = " << doubled.score << ", name = " << doubled.name
+              << " }" << std::endl;
+}
+
+static auto example_divide(int64_t dividend, int64_t divisor)
+    -> std::tuple<int64_t, int64_t>
+{
+    return { dividend / divisor, dividend % divisor };
+}
+
+static auto example_multiple_returns(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    REGISTER_TO_GLUA(glua, example_divide);
+
+    auto [message, doubled] = glua.CallScriptFunctionAs<std::tuple<std::string, int64_t>>(
+        "example_callable_from_cpp", 1337, "herpaderp");
+
+    std::cout << "example_callable_from_cpp returned: " << message << ", "
+              << doubled << std::endl;
+
+    glua.CallScriptFunction("example_multiple_returns");
+}
+
+static auto example_describe(std::variant<std::monostate, double, std::string,
+    std::vector<double>, BoxedValue, ExampleClass>
+        value) -> std::string
+{
+    switch (value.index()) {
+    case 0:
+        return "nil";
+    case 1:
+        return "number " + std::to_string(std::get<double>(value));
+    case 2:
+        return "string " + std::get<std::string>(value);
+    case 3:
+        return "table of " + std::to_string(std::get<std::vector<double>>(value).size()) + " numbers";
+    case 4:
+        return "boxed value " + std::to_string(std::get<BoxedValue>(value).GetValue());
+    default:
+        return "example class " + std::to_string(std::get<ExampleClass>(value).GetValue());
+    }
+}
+
+static auto example_variant(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    REGISTER_TO_GLUA(glua, example_describe);
+
+    glua.CallScriptFunction("example_variant");
+}
+
+static auto example_length(std::array<double, 3> vec) -> double
+{
+    return std::sqrt(vec[0] * vec[0] + vec[1] * vec[1] + vec[2] * vec[2]);
+}
+
+static auto example_sum(kdk::glua::ArrayView<double, 16> values) -> double
+{
+    double sum = 0.0;
+    for (auto value : values) {
+        sum += value;
+    }
+    return sum;
+}
+
+static auto example_fixed_size_arrays(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    REGISTER_TO_GLUA(glua, example_length);
+    REGISTER_TO_GLUA(glua, example_sum);
+
+    auto retvals = glua.CallScriptFunction("example_fixed_size_arrays");
+
+    std::array<int32_t, 8> buffer {};
+    auto count = retvals[0].ReadArray(buffer.data(), buffer.size());
+
+    std::cout << "example_fixed_size_arrays returned " << count << " values:";
+    for (size_t i = 0; i < count; ++i) {
+        std::cout << " " << buffer[i];
+    }
+    std::cout << std::endl;
+}
+
+static auto example_table_view_binding(kdk::glua::LuaTableView config) -> double
+{
+    // only the fields that are read are converted
+    auto rate = config.Get<double>("rate");
+    auto burst = config.Get<double>("burst");
+
+    size_t key_count = 0;
+    for (const auto& entry : config) {
+        (void)entry;
+        ++key_count;
+    }
+
+    std::cout << "example_table_view_binding received table with " << key_count
+              << " keys" << std::endl;
+
+    return rate * burst;
+}
+
+static auto example_table_view(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    REGISTER_TO_GLUA(glua, example_table_view_binding);
+
+    glua.CallScriptFunction("example_table_view");
+}
+
+static auto example_container_proxy(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    // the script reads and writes these containers in place, nothing is copied
+    std::vector<double> samples { 1.5, 2.5, 3.5 };
+    auto groups = std::make_shared<std::unordered_map<std::string, std::vector<int32_t>>>();
+    (*groups)["primes"] = { 2, 3, 5 };
+
+    glua.CallScriptFunction("example_container_proxy", std::ref(samples), groups);
+
+    std::cout << "samples now has " << samples.size() << " elements, last is "
+              << samples.back() << std::endl;
+    std::cout << "groups now has " << groups->size() << " keys, primes has "
+              << (*groups)["primes"].size() << " elements" << std::endl;
+}
+
+struct ExamplePoint {
+    double x;
+    double y;
+    int32_t weight;
+};
+
+// plain data structs of numbers can also be laid out for the LuaJIT FFI
+GLUA_STRUCT(ExamplePoint, &ExamplePoint::x, &ExamplePoint::y,
+    &ExamplePoint::weight)
+
+#if !defined(GLUA_BACKEND_LUA54)
+// FFI buffers and JIT control are LuaJIT only
+static auto example_ffi_buffer(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    // Lua shares ownership of the samples, and indexes them natively
+    auto samples = std::make_shared<std::vector<double>>(1000, 0.5);
+    std::vector<ExamplePoint> points { { 1.0, 2.0, 1 }, { 3.0, 4.0, 2 } };
+
+    glua.CallScriptFunction("example_ffi_buffer",
+        kdk::glua::FfiBuffer<double> { samples },
+        kdk::glua::FfiBuffer<ExamplePoint> { points.data(), points.size() });
+
+    std::cout << "samples[0] is now " << (*samples)[0] << ", points[1].x is now "
+              << points[1].x << std::endl;
+}
+
+static auto example_jit_diagnostics(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    kdk::glua::JitOptions options;
+    options.hotloop = 10;
+    glua.SetJitOptions(options);
+
+    glua.SetTraceDiagnosticsEnabled(true);
+    glua.CallScriptFunction("example_jit_diagnostics");
+    glua.SetTraceDiagnosticsEnabled(false);
+
+    const auto& report = glua.GetTraceReport();
+
+    std::cout << "traces started: "
+              << report.Count(kdk::glua::JitTraceEventType::START)
+              << ", compiled: " << report.Count(kdk::glua::JitTraceEventType::STOP)
+              << ", aborted: " << report.Count(kdk::glua::JitTraceEventType::ABORT)
+              << std::endl;
+
+    // aborted traces show where scripts fall back to the interpreter
+    for (const auto& [location, count] : report.GetAbortsByLocation()) {
+        std::cout << "aborted " << count << " times at " << location << std::endl;
+    }
+    for (const auto& [reason, count] : report.GetAbortsByReason()) {
+        std::cout << "aborted " << count << " times because: " << reason
+                  << std::endl;
+    }
+
+    glua.ClearTraceReport();
+}
+#endif
+
+static auto example_script_errors(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    // by default only the error value is kept, and nothing is formatted
+    // unless the message is read
+    try {
+        glua.CallScriptFunction("example_script_errors", "cheap");
+    } catch (const kdk::glua::LuaScriptError& error) {
+        std::cout << "error value: " << error.GetErrorMessage() << std::endl;
+    }
+
+    glua.SetErrorCaptureEnabled(true);
+
+    try {
+        glua.CallScriptFunction("example_script_errors", "detailed");
+    } catch (const kdk::glua::LuaScriptError& error) {
+        std::cout << "error raised at " << error.GetChunk() << ":"
+                  << error.GetLine() << std::endl
+                  << error.what() << std::endl;
+    }
+
+    glua.SetErrorCaptureEnabled(false);
+}
+
+#if !defined(GLUA_BACKEND_LUA54)
+// boxed 64 bit integers are LuaJIT only, Lua 5.4 has native integers
+static auto example_int64(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    // above 2^53, so a Lua number can't hold it exactly
+    uint64_t id = 18'000'000'000'000'000'001ULL;
+
+    glua.SetInt64Mode(kdk::glua::Int64Mode::CDATA_WHEN_INEXACT);
+    auto retvals = glua.CallScriptFunction("example_int64", id);
+    glua.SetInt64Mode(kdk::glua::Int64Mode::NUMBER);
+
+    std::cout << "example_int64 returned " << retvals[0].Get<uint64_t>()
+              << std::endl;
+}
+#endif
+
+struct ExampleParticle {
+    auto Speed() const -> double { return std::sqrt(vx * vx + vy * vy); }
+
+    double x = 0.0;
+    double y = 0.0;
+    double vx = 0.0;
+    double vy = 0.0;
+    const std::string kind = "example";
+};
+
+static auto example_properties(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    REGISTER_CLASS_TO_GLUA(glua, ExampleParticle, &ExampleParticle::Speed);
+
+    // data members are read/write, const members and getters are read only
+    glua.RegisterProperty<ExampleParticle>("x", &ExampleParticle::x);
+    glua.RegisterProperty<ExampleParticle>("y", &ExampleParticle::y);
+    glua.RegisterProperty<ExampleParticle>("vx", &ExampleParticle::vx);
+    glua.RegisterProperty<ExampleParticle>("vy", &ExampleParticle::vy);
+    glua.RegisterProperty<ExampleParticle>("kind", &ExampleParticle::kind);
+    glua.RegisterProperty<ExampleParticle>("speed", &ExampleParticle::Speed);
+
+    glua.RegisterProperty<BoxedValue>("value", &BoxedValue::GetValue,
+        &BoxedValue::SetValue);
+
+    ExampleParticle particle;
+    particle.vx = 3.0;
+    particle.vy = 4.0;
+
+    glua.CallScriptFunction("example_properties", std::ref(particle), 10);
+
+    std::cout << "particle moved to (" << particle.x << ", " << particle.y
+              << ")" << std::endl;
+}
+
+class ExampleDerivedValue : public BoxedValue {
+public:
+    auto Double() -> void { SetValue(GetValue() * 2); }
+};
+
+static auto example_add_to_boxed_value(BoxedValue& boxed_value, int64_t amount)
+    -> void
+{
+    boxed_value.SetValue(boxed_value.GetValue() + amount);
+}
+
+static auto example_inheritance(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    // only the derived methods are registered, the rest come from BoxedValue
+    REGISTER_CLASS_TO_GLUA(glua, ExampleDerivedValue, &ExampleDerivedValue::Double);
+    glua.RegisterBaseClass<ExampleDerivedValue, BoxedValue>();
+
+    REGISTER_TO_GLUA(glua, example_add_to_boxed_value);
+
+    glua.CallScriptFunction("example_inheritance");
+}
+
+static auto example_overloaded(int64_t value) -> std::string
+{
+    return "integer " + std::to_string(value);
+}
+
+static auto example_overloaded(std::string_view value) -> std::string
+{
+    return "string " + std::string { value };
+}
+
+static auto example_overloaded(BoxedValue& value, std::optional<int64_t> scale)
+    -> std::string
+{
+    return "boxed value " + std::to_string(value.GetValue() * scale.value_or(1));
+}
+
+static auto example_overloaded(const ExampleClass& value) -> std::string
+{
+    return "example class " + std::to_string(value.GetValue());
+}
+
+static auto example_overloads(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    // overloads still have to be resolved in C++, but share one name in Lua
+    glua.RegisterCallable("example_overloaded",
+        glua.CreateGluaOverloads(
+            static_cast<std::string (*)(int64_t)>(&example_overloaded),
+            static_cast<std::string (*)(std::string_view)>(&example_overloaded),
+            static_cast<std::string (*)(BoxedValue&, std::optional<int64_t>)>(&example_overloaded),
+            static_cast<std::string (*)(const ExampleClass&)>(&example_overloaded),
+            [](int64_t lhs, int64_t rhs) { return "two integers " + std::to_string(lhs + rhs); }));
+
+    glua.CallScriptFunction("example_overloads");
+}
+
+static auto example_identity_cache(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    glua.SetIdentityCacheEnabled<ExampleClass>(true);
+
+    auto object = ExampleClass::Create(5);
+
+    // both pushes of object, and the ExampleOverload chain, share one userdata
+    glua.CallScriptFunction("example_identity_cache", object, object);
+
+    glua.SetIdentityCacheEnabled<ExampleClass>(false);
+}
+
+static auto example_borrowed_handles(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    kdk::glua::BorrowTable borrows;
+
+    {
+        // lent for the duration of a single request, the script may hold on
+        // to it past that without keeping it alive
+        BoxedValue request_value { 7 };
+
+        glua.CallScriptFunction("example_borrowed_handles", borrows.Borrow(request_value));
+        borrows.ReleaseAll();
+    }
+
+    // the kept handle is stale now, using it raises a script error
+    try {
+        glua.CallScriptFunction("example_use_kept_borrow");
+    } catch (const kdk::glua::LuaScriptError& error) {
+        std::cout << "stale borrow: " << error.GetErrorMessage() << std::endl;
+    }
+}
+
+static auto example_print_sink(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    // a small ring, so printing in a loop drops lines instead of blocking
+    auto sink = std::make_shared<kdk::glua::BufferedPrintSink>(std::cout, 256);
+    glua.SetPrintSink(sink);
+
+    glua.CallScriptFunction("example_print_sink", 100);
+
+    // waits until the background thread wrote every line
+    sink->Flush();
+    std::cout << "buffered " << sink->GetBufferedLineCount() << " lines, dropped "
+              << sink->GetDroppedLineCount() << std::endl;
+
+    // back to writing each line as it is printed
+    glua.SetPrintSink(std::make_shared<kdk::glua::OStreamPrintSink>(std::cout));
+}
+
+static auto example_tracing(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    glua.RegisterTraceFunctions();
+
+    kdk::glua::script_tracer::start();
+    glua.CallScriptFunction("example_tracing");
+    kdk::glua::script_tracer::stop();
+
+    // open in chrome://tracing or https://ui.perfetto.dev
+    kdk::glua::script_tracer::write_chrome_trace("example_trace.json");
+    std::cout << "wrote script spans to example_trace.json" << std::endl;
+}
+
+static auto example_metrics(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    glua.SetMetricsEnabled(true);
+    glua.CallScriptFunction("example_metrics", 50);
+
+    auto snapshot = glua.GetMetrics().Snapshot();
+
+    for (const auto& callable : snapshot.callables) {
+        std::cout << callable.name << " called " << callable.call_count
+                  << " times, p99 " << callable.LatencyAtQuantile(0.99) << "ns"
+                  << std::endl;
+    }
+
+    std::cout << snapshot.ToPrometheusText();
+
+    glua.SetMetricsEnabled(false);
+}
+
+static auto example_stack_scope(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    // everything pushed below is dropped with one settop when scope exits
+    kdk::glua::StackScope scope { &glua };
+
+    auto retvals = glua.CallScriptFunction("example_stack_scope");
+    auto tenants_index = scope.PushChild(retvals[0].GetStackIndex(), "tenants");
+    auto tenant_count = glua.GetArrayLength(tenants_index);
+    auto total_rate = 0.0;
+
+    for (size_t i = 0; i < tenant_count; ++i) {
+        auto tenant_index = scope.PushChild(tenants_index, i);
+        total_rate += scope.GetChild<double>(tenant_index, "rate");
+    }
+
+    std::cout << tenant_count << " tenants, total rate " << total_rate
+              << std::endl;
+
+    // the return values are dropped with everything else when scope exits
+    for (auto& retval : retvals) {
+        retval.Release();
+    }
+}
+
+static auto example_table_path(kdk::glua::GluaBackend& glua) -> void
+{
+    std::cout << std::endl
+              << __FUNCTION__ << " starting..." << std::endl;
+
+    // compiled once, then every evaluation is a single walk with raw gets
+    kdk::glua::TablePath tenant_rate { &glua, "example_limits.tenants[2].rate" };
+    kdk::glua::TablePath tenant_name { &glua, "tenants[0].name" };
+
+    glua.CallScriptFunction("example_table_path");
+
+    std::cout << "global tenant rate " << tenant_rate.GetGlobal<double>()
+              << std::endl;
+
+    auto retvals = glua.CallScriptFunction("example_stack_scope");
+
+    std::cout << "first tenant "
+              << tenant_name.Get<std::string>(retvals[0].GetStackIndex())
+              << std::endl;
+}
+
 auto main(int argc, char* argv[]) -> int
 {
-    kdk::glua::GluaLua glua { std::cout };
+    kdk::glua::GluaBackend glua { std::cout };
 
     ///////////// ADD CUSTOM BINDINDS HERE /////////////
     REGISTER_TO_GLUA(glua, example_binding);
@@ -431,6 +947,30 @@ auto main(int argc, char* argv[]) -> int
         example_nested_table(glua);
         example_bind_lambda(glua);
         example_lua_array(glua);
+        example_struct(glua);
+        example_multiple_returns(glua);
+        example_variant(glua);
+        example_fixed_size_arrays(glua);
+        example_table_view(glua);
+        example_container_proxy(glua);
+#if !defined(GLUA_BACKEND_LUA54)
+        example_ffi_buffer(glua);
+        example_jit_diagnostics(glua);
+#endif
+        example_script_errors(glua);
+#if !defined(GLUA_BACKEND_LUA54)
+        example_int64(glua);
+#endif
+        example_properties(glua);
+        example_inheritance(glua);
+        example_overloads(glua);
+        example_identity_cache(glua);
+        example_borrowed_handles(glua);
+        example_print_sink(glua);
+        example_tracing(glua);
+        example_metrics(glua);
+        example_stack_scope(glua);
+        example_table_path(glua);
     }
 
     return 0;